@@ -0,0 +1,313 @@
+// cppobjectpool 的 Google Benchmark 基准测试
+// 编译：g++ -std=c++17 -O2 -I. bench/cppobjectpool_bench.cpp -lbenchmark -pthread -o cppobjectpool_bench
+// 每个用例输出 ops/s 以及单次操作延迟的 p50/p99/p999(纳秒，包含一次 steady_clock 计时的开销)
+
+#include "cppobjectpool.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+    // 被池化的对象，大小为一个缓存行
+    struct Payload
+    {
+        char data[64];
+    };
+
+    // 清零对象的编译期后处理函数
+    struct ResetPayload
+    {
+        void operator()(Payload* payload) const
+        {
+            std::memset(payload->data, 0, sizeof(payload->data));
+        }
+    };
+
+    // 清零对象的运行期后处理函数
+    void resetPayload(Payload* payload)
+    {
+        std::memset(payload->data, 0, sizeof(payload->data));
+    }
+
+    // 开启线程本地缓存的对象池使用的缓存深度
+    constexpr size_t kThreadCacheSize = 64;
+
+    // 记录每次操作的耗时，结束时把 ops/s 与延迟分位数写入 state.counters
+    class LatencyRecorder
+    {
+    public:
+        explicit LatencyRecorder(benchmark::State& state)
+            : m_state(state)
+        {
+            m_samples.reserve(1 << 16);
+        }
+
+        // 计时一次操作
+        template <typename Func>
+        void measure(Func&& func)
+        {
+            auto begin = std::chrono::steady_clock::now();
+            func();
+            auto end = std::chrono::steady_clock::now();
+            m_samples.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+        }
+
+        // 多线程用例中每个线程各自上报，分位数取各线程的平均值，ops/s 取总和
+        ~LatencyRecorder()
+        {
+            m_state.counters["ops/s"] = benchmark::Counter(static_cast<double>(m_state.iterations()),
+                benchmark::Counter::kIsRate);
+            if (m_samples.empty())
+            {
+                return;
+            }
+            std::sort(m_samples.begin(), m_samples.end());
+            m_state.counters["p50_ns"] = benchmark::Counter(percentile(0.50), benchmark::Counter::kAvgThreads);
+            m_state.counters["p99_ns"] = benchmark::Counter(percentile(0.99), benchmark::Counter::kAvgThreads);
+            m_state.counters["p999_ns"] = benchmark::Counter(percentile(0.999), benchmark::Counter::kAvgThreads);
+        }
+
+    private:
+        double percentile(double p) const
+        {
+            size_t index = static_cast<size_t>(p * static_cast<double>(m_samples.size() - 1));
+            return static_cast<double>(m_samples[index]);
+        }
+
+        benchmark::State& m_state;
+        std::vector<int64_t> m_samples;
+    };
+
+    // 创建基准测试使用的对象池
+    template <typename Pool>
+    std::shared_ptr<Pool> makePool(size_t initialSize, bool threadCache)
+    {
+        auto pool = Pool::create(initialSize, std::numeric_limits<size_t>::max());
+        if (threadCache)
+        {
+            pool->setThreadCacheSize(kThreadCacheSize);
+        }
+        return pool;
+    }
+
+    // 所有线程共享的对象池，由第一个线程创建，最后一个用例结束时随静态变量销毁
+    template <typename Pool, bool ThreadCache>
+    std::shared_ptr<Pool>& sharedPool()
+    {
+        static std::shared_ptr<Pool> pool = makePool<Pool>(1024, ThreadCache);
+        return pool;
+    }
+
+    using MutexPool = cppobjectpool::ObjectPool<Payload>;
+    using LockFreePool = cppobjectpool::LockFreeObjectPool<Payload>;
+    using SlabPool = cppobjectpool::SlabObjectPool<Payload>;
+    using HookedPool = cppobjectpool::HookedObjectPool<Payload, cppobjectpool::NoHook, ResetPayload>;
+    using ShardedPool = cppobjectpool::ShardedObjectPool<Payload>;
+    using CacheAlignedPool = cppobjectpool::CacheAlignedObjectPool<Payload>;
+    using SpinLockPool = cppobjectpool::SpinLockObjectPool<Payload>;
+    using AdaptiveLockPool = cppobjectpool::AdaptiveLockObjectPool<Payload>;
+}
+
+// 基线：每次 new/delete
+static void BM_NewDelete(benchmark::State& state)
+{
+    LatencyRecorder recorder(state);
+    for (auto _ : state)
+    {
+        recorder.measure([] {
+            Payload* payload = new Payload;
+            benchmark::DoNotOptimize(payload);
+            delete payload;
+        });
+    }
+}
+BENCHMARK(BM_NewDelete)->ThreadRange(1, 64)->UseRealTime();
+
+// 基线：每次 std::make_unique
+static void BM_MakeUnique(benchmark::State& state)
+{
+    LatencyRecorder recorder(state);
+    for (auto _ : state)
+    {
+        recorder.measure([] {
+            auto payload = std::make_unique<Payload>();
+            benchmark::DoNotOptimize(payload.get());
+        });
+    }
+}
+BENCHMARK(BM_MakeUnique)->ThreadRange(1, 64)->UseRealTime();
+
+// 单线程 acquire/release 往返
+template <typename Pool, bool ThreadCache>
+static void BM_RoundTrip(benchmark::State& state)
+{
+    auto pool = makePool<Pool>(16, ThreadCache);
+    LatencyRecorder recorder(state);
+    for (auto _ : state)
+    {
+        recorder.measure([&] {
+            auto obj = pool->acquire();
+            benchmark::DoNotOptimize(obj.get());
+        });
+    }
+}
+BENCHMARK_TEMPLATE(BM_RoundTrip, MutexPool, false);
+BENCHMARK_TEMPLATE(BM_RoundTrip, MutexPool, true);
+BENCHMARK_TEMPLATE(BM_RoundTrip, LockFreePool, false);
+BENCHMARK_TEMPLATE(BM_RoundTrip, SlabPool, false);
+
+// N 个线程竞争同一个对象池
+template <typename Pool, bool ThreadCache>
+static void BM_Contention(benchmark::State& state)
+{
+    auto pool = sharedPool<Pool, ThreadCache>();
+    LatencyRecorder recorder(state);
+    for (auto _ : state)
+    {
+        recorder.measure([&] {
+            auto obj = pool->acquire();
+            benchmark::DoNotOptimize(obj.get());
+        });
+    }
+}
+BENCHMARK_TEMPLATE(BM_Contention, MutexPool, false)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Contention, MutexPool, true)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Contention, LockFreePool, false)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Contention, ShardedPool, false)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Contention, CacheAlignedPool, false)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Contention, SpinLockPool, false)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Contention, AdaptiveLockPool, false)->ThreadRange(1, 64)->UseRealTime();
+
+// 锁策略对比：每次往返之间在锁外执行 range(0) 次 pause，模拟线程在两次获取之间的工作量
+// 0 时锁竞争最激烈，自旋锁与自适应锁在线程数不超过核数时领先；线程数超过核数时自旋锁的持锁线程会被抢占，
+// std::mutex 与自适应锁领先；锁外工作量增大后竞争变少，三者都很少进入慢路径
+template <typename Pool>
+static void BM_LockPolicy(benchmark::State& state)
+{
+    auto pool = sharedPool<Pool, false>();
+    int64_t work = state.range(0);
+    LatencyRecorder recorder(state);
+    for (auto _ : state)
+    {
+        recorder.measure([&] {
+            auto obj = pool->acquire();
+            benchmark::DoNotOptimize(obj.get());
+        });
+        for (int64_t i = 0; i < work; ++i)
+        {
+            cppobjectpool::cpuRelax();
+        }
+    }
+}
+BENCHMARK_TEMPLATE(BM_LockPolicy, MutexPool)->Arg(0)->Arg(256)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LockPolicy, SpinLockPool)->Arg(0)->Arg(256)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_LockPolicy, AdaptiveLockPool)->Arg(0)->Arg(256)->ThreadRange(1, 64)->UseRealTime();
+
+// 生产者/消费者：偶数线程获取对象并交给奇数线程释放
+// 开启线程本地缓存时，释放的对象经远程释放列表回到生产者线程
+template <typename Pool, bool ThreadCache>
+static void BM_ProducerConsumer(benchmark::State& state)
+{
+    // 每对线程共享一个队列
+    struct Channel
+    {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::unique_ptr<Payload, typename Pool::CustomDeleter>> queue;
+    };
+    static std::vector<Channel> channels(32);
+
+    auto pool = sharedPool<Pool, ThreadCache>();
+    Channel& channel = channels[static_cast<size_t>(state.thread_index()) / 2];
+    bool producer = state.thread_index() % 2 == 0;
+    LatencyRecorder recorder(state);
+    for (auto _ : state)
+    {
+        if (producer)
+        {
+            std::unique_ptr<Payload, typename Pool::CustomDeleter> obj;
+            recorder.measure([&] { obj = pool->acquire(); });
+            {
+                std::lock_guard<std::mutex> lock(channel.mutex);
+                channel.queue.push_back(std::move(obj));
+            }
+            channel.cv.notify_one();
+        }
+        else
+        {
+            std::unique_ptr<Payload, typename Pool::CustomDeleter> obj;
+            {
+                std::unique_lock<std::mutex> lock(channel.mutex);
+                channel.cv.wait(lock, [&] { return !channel.queue.empty(); });
+                obj = std::move(channel.queue.front());
+                channel.queue.pop_front();
+            }
+            recorder.measure([&] { pool->release(std::move(obj)); });
+        }
+    }
+}
+BENCHMARK_TEMPLATE(BM_ProducerConsumer, MutexPool, false)->ThreadRange(2, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ProducerConsumer, MutexPool, true)->ThreadRange(2, 64)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ProducerConsumer, LockFreePool, false)->ThreadRange(2, 64)->UseRealTime();
+
+// 冷启动：对象池从 initialSize 开始增长到 range(0) 个对象，统计每个对象的耗时
+template <typename Pool>
+static void BM_ColdStartGrowth(benchmark::State& state)
+{
+    size_t count = static_cast<size_t>(state.range(0));
+    std::vector<std::unique_ptr<Payload, typename Pool::CustomDeleter>> objects;
+    objects.reserve(count);
+    LatencyRecorder recorder(state);
+    for (auto _ : state)
+    {
+        auto pool = makePool<Pool>(16, false);
+        for (size_t i = 0; i < count; ++i)
+        {
+            recorder.measure([&] { objects.push_back(pool->acquire()); });
+        }
+        objects.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(count));
+}
+BENCHMARK_TEMPLATE(BM_ColdStartGrowth, MutexPool)->Arg(1024)->Arg(65536);
+BENCHMARK_TEMPLATE(BM_ColdStartGrowth, SlabPool)->Arg(1024)->Arg(65536);
+
+// 处理函数：关闭、运行期 std::function、编译期策略
+static void BM_HooksOff(benchmark::State& state)
+{
+    BM_RoundTrip<MutexPool, false>(state);
+}
+BENCHMARK(BM_HooksOff);
+
+static void BM_HooksRuntime(benchmark::State& state)
+{
+    auto pool = makePool<MutexPool>(16, false);
+    pool->setPostProcess(resetPayload);
+    LatencyRecorder recorder(state);
+    for (auto _ : state)
+    {
+        recorder.measure([&] {
+            auto obj = pool->acquire();
+            benchmark::DoNotOptimize(obj.get());
+        });
+    }
+}
+BENCHMARK(BM_HooksRuntime);
+
+static void BM_HooksCompileTime(benchmark::State& state)
+{
+    BM_RoundTrip<HookedPool, false>(state);
+}
+BENCHMARK(BM_HooksCompileTime);
+
+BENCHMARK_MAIN();
@@ -4,12 +4,72 @@
 // 引入必要的标准库头文件
 #include <iostream>
 #include <mutex>
+#include <condition_variable>
 #include <memory>
+#include <memory_resource>
 #include <functional>
 #include <vector>
 #include <atomic>
 #include <utility>
-#include <unordered_set>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <chrono>
+#include <array>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <future>
+#include <system_error>
+#include <stdexcept>
+#include <cstdio>
+#include <cstdlib>
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+// 以 C++20 编译时提供 co_await acquire_async()
+#define CPPOBJECTPOOL_COROUTINES 1
+#endif
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+#if defined(__linux__) && __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+// 安装了 systemtap-sdt-dev 时提供以 USDT 静态探针输出追踪事件的 UsdtTracer
+#define CPPOBJECTPOOL_USDT 1
+#endif
+// 取得调用当前函数的指令地址，作为追踪事件中的调用点；函数被内联时为外层函数的返回地址
+#if defined(__GNUC__) || defined(__clang__)
+#define CPPOBJECTPOOL_CALL_SITE() __builtin_return_address(0)
+#else
+#define CPPOBJECTPOOL_CALL_SITE() nullptr
+#endif
+#if defined(__SANITIZE_THREAD__)
+#define CPPOBJECTPOOL_TSAN 1
+#elif defined(__has_feature)
+#if __has_feature(thread_sanitizer)
+#define CPPOBJECTPOOL_TSAN 1
+#endif
+#endif
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_16)) \
+    && !defined(CPPOBJECTPOOL_TSAN)
+// 平台提供 16 字节的 CAS(x86-64 的 cmpxchg16b 或编译器内建)时，无锁栈的栈顶使用完整的指针与 64 位版本号
+// ThreadSanitizer 看不到内联汇编中的同步，此时仍使用 64 位打包的栈顶
+#define CPPOBJECTPOOL_DWCAS 1
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+// POSIX 平台上提供 shm_open/mmap 共享内存中的跨进程对象池 SharedMemoryObjectPool
+#define CPPOBJECTPOOL_SHARED_MEMORY 1
+#endif
 
 // 定义命名空间 cppobjectpool
 namespace cppobjectpool
@@ -35,275 +95,5069 @@ namespace cppobjectpool
     using std::make_index_sequence;
 #endif
 
-    // 定义对象池模板类，T 是对象的类型，Args 是对象构造函数的参数类型
-    template <typename T, typename... Args>
-    class ObjectPool : public std::enable_shared_from_this<ObjectPool<T, Args...>>
+    // 无锁侵入式栈(Treiber 栈)，Node 需要提供 std::atomic<Node*> next 成员
+    // 每次修改栈顶都会递增版本号，用于避免 ABA 问题：支持 16 字节 CAS 的平台上栈顶是完整的指针加 64 位版本号，
+    // 版本号不会回绕；其它 64 位平台上指针占低 48 位、版本号占高 16 位，要求节点地址不超过 48 位，压入时检查
+    template <typename Node>
+    class LockFreeStack
     {
     public:
-        // 定义预处理函数类型，用于在获取对象前对对象进行处理
-        using PreProcess = std::function<void(T*)>;
-        // 定义后处理函数类型，用于在释放对象后对对象进行处理
-        using PostProcess = std::function<void(T*)>;
-        // 定义最终处理函数类型，用于在对象被销毁前对对象进行处理
-        using FinalProcess = std::function<void(T*)>;
-    public:
-        // 自定义删除器结构体，用于在对象释放时将其放回对象池
-        struct CustomDeleter
+        // 压入一个节点
+        void push(Node* node)
         {
-            // 弱引用指向对象池，避免循环引用
-            std::weak_ptr<ObjectPool<T, Args...>> pool_weak;
-            // 存储最终处理函数
-            FinalProcess finalProcess;
-            // 重载函数调用运算符，当对象被删除时调用
-            void operator()(T* ptr)
+            pushChain(node, node);
+        }
+
+        // 一次压入 first 到 last 之间已经通过 next 链接好的一串节点
+        void pushChain(Node* first, Node* last)
+        {
+            Head head = loadHead();
+            do
+            {
+                last->next.store(head.node, std::memory_order_relaxed);
+            } while (!casHead(head, first));
+        }
+
+        // 弹出一个节点，栈为空时返回空指针
+        Node* pop()
+        {
+            Head head = loadHead();
+            for (;;)
             {
-                // 尝试锁定弱引用，获取对象池的共享指针
-                if (auto pool = pool_weak.lock())
+                Node* node = head.node;
+                if (!node)
                 {
-                    // std::cout << "operator()" << std::endl;
-                    // 如果成功获取对象池的共享指针，将对象放回对象池
-                    pool->release(std::unique_ptr<T, CustomDeleter>(ptr, *this));
+                    return nullptr;
                 }
-                else
+                // 节点可能已被其它线程弹出，此时读到的 next 会因版本号变化而在 CAS 时被丢弃；
+                // 使用方需保证节点内存在栈存活期间不被释放，否则这里的读取会访问已释放的内存
+                Node* next = node->next.load(std::memory_order_relaxed);
+                if (casHead(head, next))
                 {
-                    if (finalProcess)
-                    {
-                        // 如果最终处理函数不为空，调用最终处理函数
-                        finalProcess(ptr);
-                    }
-                    delete ptr;
-                    ptr = nullptr;
+                    return node;
                 }
             }
+        }
+
+        // 弹出所有节点，返回原栈顶，节点之间仍通过 next 链接
+        Node* popAll()
+        {
+            Head head = loadHead();
+            while (head.node && !casHead(head, nullptr))
+            {
+            }
+            return head.node;
+        }
+
+    private:
+        // 栈顶的指针与版本号
+        struct Head
+        {
+            Node* node;
+            uint64_t tag;
         };
 
-        int getRealAllockedCount()
+#if defined(CPPOBJECTPOOL_DWCAS)
+        // 读取栈顶，两半分别原子读取；读到不一致的组合时随后的 CAS 失败并取回当前值
+        Head loadHead() const
         {
-            return m_realAllocedCount;
+            Head head;
+            head.tag = __atomic_load_n(&m_head.tag, __ATOMIC_ACQUIRE);
+            head.node = reinterpret_cast<Node*>(__atomic_load_n(&m_head.pointer, __ATOMIC_ACQUIRE));
+            return head;
         }
 
-        // 静态工厂方法，用于创建对象池的共享指针
-        static std::shared_ptr<ObjectPool> create(
-            // 对象池的初始大小，默认为 10
-            size_t initialSize = 10,
-            // 对象池的最大大小，默认为 size_t 类型的最大值
-            size_t maxSize = std::numeric_limits<size_t>::max(),
-            // 对象构造函数的参数
-            Args&&... args)
+        // 栈顶仍为 expected 时换成 node 并递增版本号，失败时把当前栈顶写回 expected；带完整的内存屏障
+        bool casHead(Head& expected, Node* node)
         {
-            // 创建对象池的共享指针
-            auto pool = std::shared_ptr<ObjectPool>(new ObjectPool(
-                initialSize, maxSize, std::forward<Args>(args)...));
-            return pool;
+            uint64_t pointer = reinterpret_cast<uintptr_t>(expected.node);
+            uint64_t tag = expected.tag;
+#if defined(__x86_64__)
+            bool swapped;
+            __asm__ __volatile__("lock cmpxchg16b %1\n\tsete %0"
+                : "=q"(swapped), "+m"(m_head), "+a"(pointer), "+d"(tag)
+                : "b"(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(node))), "c"(expected.tag + 1)
+                : "cc", "memory");
+#else
+            using Word = unsigned __int128;
+            Word desired = (static_cast<Word>(expected.tag + 1) << 64) | reinterpret_cast<uintptr_t>(node);
+            Word current = __sync_val_compare_and_swap(reinterpret_cast<Word*>(&m_head),
+                (static_cast<Word>(tag) << 64) | pointer, desired);
+            bool swapped = current == ((static_cast<Word>(tag) << 64) | pointer);
+            pointer = static_cast<uint64_t>(current);
+            tag = static_cast<uint64_t>(current >> 64);
+#endif
+            expected.node = reinterpret_cast<Node*>(static_cast<uintptr_t>(pointer));
+            expected.tag = tag;
+            return swapped;
         }
 
-        // 设置预处理函数
-        void setPreProcess(PreProcess preProcess)
+        // 栈顶，按 16 字节对齐以便整体 CAS
+        struct alignas(16) PackedHead
         {
-            m_preProcess = preProcess;
+            uint64_t pointer;
+            uint64_t tag;
+        };
+        PackedHead m_head{ 0, 0 };
+#else
+        static_assert(sizeof(void*) <= sizeof(uint64_t), "LockFreeStack packs a pointer into 64 bits");
+
+        // 指针所占的位数
+        static constexpr unsigned kPointerBits = sizeof(void*) == 8 ? 48 : 32;
+        // 指针部分的掩码
+        static constexpr uint64_t kPointerMask = (uint64_t(1) << kPointerBits) - 1;
+
+        // 读取栈顶
+        Head loadHead() const
+        {
+            return unpack(m_head.load(std::memory_order_acquire));
         }
 
-        // 设置后处理函数
-        void setPostProcess(PostProcess postProcess)
+        // 栈顶仍为 expected 时换成 node 并递增版本号，失败时把当前栈顶写回 expected
+        bool casHead(Head& expected, Node* node)
         {
-            m_postProcess = postProcess;
+            checkAddress(node);
+            uint64_t head = pack(expected.node, expected.tag);
+            bool swapped = m_head.compare_exchange_weak(head, pack(node, expected.tag + 1),
+                std::memory_order_acq_rel, std::memory_order_acquire);
+            expected = unpack(head);
+            return swapped;
         }
 
-        // 设置最终处理函数
-        void setFinalProcess(FinalProcess finalProcess)
+        // 节点地址超出 kPointerBits 位(例如开启 5 级页表或指针标记)时无法打包，直接终止而不是破坏栈
+        static void checkAddress(Node* node)
         {
-            m_finalProcess = finalProcess;
-            // 更新自定义删除器中的最终处理函数
-            for (const auto& ptr : m_pool)
+            if ((static_cast<uint64_t>(reinterpret_cast<uintptr_t>(node)) & ~kPointerMask) != 0)
             {
-                // 这里不需要额外处理，因为删除器在对象归还时才会起作用
+                std::fprintf(stderr, "cppobjectpool: LockFreeStack node address %p exceeds %u bits\n",
+                    static_cast<void*>(node), kPointerBits);
+                std::abort();
             }
         }
 
-        // 析构函数，用于清理对象池
-        ~ObjectPool()
+        // 将指针与版本号打包，版本号只保留高位能容纳的部分
+        static uint64_t pack(Node* node, uint64_t tag)
         {
-            // 清空对象池
-            clear();
+            return (tag << kPointerBits) | (static_cast<uint64_t>(reinterpret_cast<uintptr_t>(node)) & kPointerMask);
         }
 
-        // 获取对象的方法，返回一个智能指针
-        std::unique_ptr<T, CustomDeleter> acquire()
+        // 拆开打包的栈顶
+        static Head unpack(uint64_t head)
+        {
+            return Head{ reinterpret_cast<Node*>(static_cast<uintptr_t>(head & kPointerMask)), head >> kPointerBits };
+        }
+
+        // 打包后的栈顶
+        std::atomic<uint64_t> m_head{ 0 };
+#endif
+    };
+
+    // 缓存行大小
+    constexpr std::size_t kCacheLineSize = 64;
+
+    // 空的处理函数策略，表示不使用对应的处理函数，调用会在编译期被完全去掉
+    struct NoHook
+    {
+        template <typename U>
+        void operator()(U*) const {}
+    };
+
+    // 追踪事件
+    enum class TraceEvent
+    {
+        // 从空闲列表或线程本地缓存复用对象
+        AcquireHit,
+        // 空闲列表为空，新建对象
+        AcquireMiss,
+        // 达到最大大小或超出分区配额，获取失败(object 为空)
+        AcquireFail,
+        // 对象被释放
+        Release,
+        // 释放时空闲列表已满，对象被销毁
+        Drop,
+        // 调用 clear()(object 为空)
+        Clear,
+    };
+
+    // 空的追踪策略，表示不追踪，追踪点在编译期被完全去掉
+    struct NoTracer
+    {
+        void operator()(TraceEvent, uint64_t, const void*, const void*) const {}
+    };
+
+#if defined(CPPOBJECTPOOL_USDT)
+    // 以 USDT 静态探针输出追踪事件，探针未被附加时只是一条 nop，可以随时用 perf/bpftrace 附加到运行中的进程：
+    // bpftrace -e 'usdt:./server:cppobjectpool:acquire_miss { @[ustack] = count(); }'
+    // 探针参数依次为对象池标识、对象地址与采样到的调用点
+    struct UsdtTracer
+    {
+        void operator()(TraceEvent event, uint64_t poolId, const void* object, const void* callSite) const
         {
-            std::unique_ptr<T> ptr;
+            switch (event)
             {
-                // 加锁，保证线程安全
-                std::lock_guard<std::mutex> lock(m_mutex);
-                // 如果对象池不为空
-                if (!m_pool.empty())
-                {
-                    // 从对象池的末尾取出一个对象
-                    ptr = std::move(m_pool.back());
-                    m_pool.pop_back();
-                    // 从跟踪集合中移除该指针
-                    m_releasedPtrs.erase(ptr.get());
-                }
-                // 如果对象池为空且已分配的对象数量小于最大大小
-                else if (m_acquiredCount < m_maxSize)
+            case TraceEvent::AcquireHit:
+                DTRACE_PROBE3(cppobjectpool, acquire_hit, poolId, object, callSite);
+                break;
+            case TraceEvent::AcquireMiss:
+                DTRACE_PROBE3(cppobjectpool, acquire_miss, poolId, object, callSite);
+                break;
+            case TraceEvent::AcquireFail:
+                DTRACE_PROBE3(cppobjectpool, acquire_fail, poolId, object, callSite);
+                break;
+            case TraceEvent::Release:
+                DTRACE_PROBE3(cppobjectpool, release, poolId, object, callSite);
+                break;
+            case TraceEvent::Drop:
+                DTRACE_PROBE3(cppobjectpool, drop, poolId, object, callSite);
+                break;
+            case TraceEvent::Clear:
+                DTRACE_PROBE3(cppobjectpool, clear, poolId, object, callSite);
+                break;
+            }
+        }
+    };
+#endif
+
+    // 把一个函数(或函数指针常量)包装成可默认构造的处理函数策略，例如 FunctionHook<&resetMessage>
+    template <auto Func>
+    struct FunctionHook
+    {
+        template <typename U>
+        void operator()(U* ptr) const
+        {
+            Func(ptr);
+        }
+    };
+
+    // 对象回收时的原地重置协议：对象归还时调用 reset(object)，对象本身不会被析构和重建，
+    // 因此 std::vector/std::string 等成员的容量在复用之间得以保留
+    // 默认对带有 reset() 成员函数的类型调用 object.reset()，其它类型可以特化该模板：
+    // template <> struct reset_traits<Message> { static constexpr bool enabled = true; static void reset(Message& m); };
+    template <typename T, typename = void>
+    struct reset_traits
+    {
+        static constexpr bool enabled = false;
+    };
+
+    template <typename T>
+    struct reset_traits<T, std::void_t<decltype(std::declval<T&>().reset())>>
+    {
+        static constexpr bool enabled = true;
+
+        static void reset(T& object)
+        {
+            object.reset();
+        }
+    };
+
+    // 系统中 NUMA 节点的数量，非 Linux 平台或无法读取时为 1
+    inline std::size_t numaNodeCount()
+    {
+        static const std::size_t count = [] {
+            std::size_t nodes = 1;
+#if defined(__linux__)
+            // 格式形如 "0" 或 "0-1,3"，取最大的节点编号
+            std::ifstream file("/sys/devices/system/node/online");
+            std::string text;
+            if (file >> text)
+            {
+                std::size_t value = 0;
+                bool digit = false;
+                for (char c : text + ",")
                 {
-                    // 创建一个新对象
-                    ptr = createObject();
-                    // 增加已分配的对象数量
-                    ++m_acquiredCount;
+                    if (c >= '0' && c <= '9')
+                    {
+                        value = value * 10 + static_cast<std::size_t>(c - '0');
+                        digit = true;
+                    }
+                    else
+                    {
+                        if (digit) nodes = std::max(nodes, value + 1);
+                        value = 0;
+                        digit = false;
+                    }
                 }
             }
+#endif
+            return nodes;
+        }();
+        return count;
+    }
 
-            // 如果成功获取到对象且预处理函数不为空
-            if (ptr && m_preProcess)
+    // 当前线程所在的 NUMA 节点，每 256 次调用才通过 getcpu 刷新一次，线程迁移后会短暂滞后
+    inline std::size_t currentNumaNode()
+    {
+#if defined(__linux__) && defined(SYS_getcpu)
+        static thread_local unsigned node = 0;
+        static thread_local unsigned countdown = 0;
+        if (countdown-- == 0)
+        {
+            unsigned cpu = 0;
+            if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0)
             {
-                // 调用预处理函数
-                m_preProcess(ptr.get());
+                node = 0;
             }
+            countdown = 255;
+        }
+        return node;
+#else
+        return 0;
+#endif
+    }
 
-            // 返回一个智能指针，使用自定义删除器
-            return std::unique_ptr<T, CustomDeleter>(ptr.release(), CustomDeleter{ this->weak_from_this(), m_finalProcess });
+    // 当前线程所在的 CPU，刷新方式同 currentNumaNode()；不支持 getcpu 的平台上返回线程标识的哈希值
+    inline std::size_t currentCpu()
+    {
+#if defined(__linux__) && defined(SYS_getcpu)
+        static thread_local unsigned cpu = 0;
+        static thread_local unsigned countdown = 0;
+        if (countdown-- == 0)
+        {
+            if (syscall(SYS_getcpu, &cpu, nullptr, nullptr) != 0)
+            {
+                cpu = static_cast<unsigned>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+            }
+            countdown = 255;
         }
+        return cpu;
+#else
+        static thread_local std::size_t id = std::hash<std::thread::id>()(std::this_thread::get_id());
+        return id;
+#endif
+    }
 
-        // 获取对象池中空闲对象的数量
-        size_t getAvailableCount() const
+    // 让一段内存优先从指定 NUMA 节点分配物理页，必须在首次访问之前调用
+    // 只处理完整落在范围内的页，不支持的平台上什么也不做
+    inline void bindToNumaNode(void* memory, std::size_t size, std::size_t node)
+    {
+#if defined(__linux__) && defined(SYS_mbind)
+        const uintptr_t page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        uintptr_t begin = (reinterpret_cast<uintptr_t>(memory) + page - 1) / page * page;
+        uintptr_t end = (reinterpret_cast<uintptr_t>(memory) + size) / page * page;
+        constexpr std::size_t kMaskBits = sizeof(unsigned long) * 8;
+        if (begin >= end || node >= kMaskBits)
         {
-            // 加锁，保证线程安全
-            std::lock_guard<std::mutex> lock(m_mutex);
-            return m_pool.size();
+            return;
+        }
+        // MPOL_PREFERRED，MPOL_MF_MOVE：已分配的页也迁移到该节点
+        const int kMpolPreferred = 1;
+        const unsigned kMpolMfMove = 1u << 1;
+        unsigned long mask = 1ul << node;
+        syscall(SYS_mbind, begin, end - begin, kMpolPreferred, &mask, kMaskBits, kMpolMfMove);
+#else
+        (void)memory;
+        (void)size;
+        (void)node;
+#endif
+    }
+
+    // 自旋等待时提示 CPU 当前处于忙等，降低功耗并让出超线程的执行资源
+    inline void cpuRelax()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield");
+#else
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+    }
+
+    // 64 位字中最低的置位位的下标，word 不能为 0
+    inline unsigned countTrailingZeros(uint64_t word)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        return static_cast<unsigned>(__builtin_ctzll(word));
+#else
+        unsigned index = 0;
+        for (; (word & 1) == 0; word >>= 1)
+        {
+            ++index;
         }
+        return index;
+#endif
+    }
 
-        // 清空对象池
-        void clear()
+    // 提示 CPU 预取即将访问的内存
+    inline void prefetch(const void* address)
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(address);
+#else
+        (void)address;
+#endif
+    }
+
+    // TTAS 自旋锁：只在锁看起来空闲时才尝试交换，等待期间只读本地缓存行，
+    // 失败后按指数退避(每次加倍 pause 次数)，退避到上限后每轮让出一次时间片
+    // 适合临界区只有几十纳秒、线程数不超过核数的场景，持锁线程被抢占时其它线程会一直空转
+    class SpinLock
+    {
+    public:
+        void lock()
         {
+            for (;;)
             {
-                // 加锁，保证对对象池的操作线程安全
-                std::lock_guard<std::mutex> lock(m_mutex);
-                // 遍历对象池中的所有对象
-                for (auto& ptr : m_pool)
+                if (!m_locked.exchange(true, std::memory_order_acquire))
+                {
+                    return;
+                }
+                unsigned backoff = 1;
+                while (m_locked.load(std::memory_order_relaxed))
                 {
-                    // 从跟踪集合中移除该指针
-                    m_releasedPtrs.erase(ptr.get());
-                    // 如果最终处理函数不为空
-                    if (m_finalProcess)
+                    if (backoff < kMaxBackoff)
+                    {
+                        for (unsigned i = 0; i < backoff; ++i)
+                        {
+                            cpuRelax();
+                        }
+                        backoff <<= 1;
+                    }
+                    else
                     {
-                        // 调用最终处理函数
-                        m_finalProcess(ptr.get());
+                        std::this_thread::yield();
                     }
-                    // 对象会在离开作用域时自动删除
                 }
-                // 清空对象池
-                m_pool.clear();
             }
-            // 清空跟踪集合
-            m_releasedPtrs.clear();
         }
 
-        // 保护对象池的互斥锁
-        mutable std::mutex m_mutex;
-        // 存储空闲对象的向量，使用 std::unique_ptr
-        std::vector<std::unique_ptr<T>> m_pool;
-        // 对象池的最大大小
-        size_t m_maxSize;
-        // 预处理函数
-        PreProcess m_preProcess;
-        // 后处理函数
-        PostProcess m_postProcess;
-        // 最终处理函数
-        FinalProcess m_finalProcess;
-        // 已分配的对象数量(随回收变化)
-        std::atomic<size_t> m_acquiredCount{ 0 };
-        // 分配过的对象数量
-        std::atomic<size_t> m_realAllocedCount{ 0 };
-        // 存储对象构造函数参数的元组
-        std::tuple<Args...> m_constructorArgs;
-        // 跟踪已释放的对象指针
-        std::unordered_set<T*> m_releasedPtrs;
+        bool try_lock()
+        {
+            return !m_locked.load(std::memory_order_relaxed) && !m_locked.exchange(true, std::memory_order_acquire);
+        }
 
-        // 构造函数
-        ObjectPool(size_t initialSize,
-            size_t maxSize,
-            Args&&... args)
-            : m_maxSize(maxSize),
-            m_constructorArgs(std::forward<Args>(args)...)
+        void unlock()
         {
-            try
+            m_locked.store(false, std::memory_order_release);
+        }
+
+    private:
+        // 单轮退避的 pause 次数上限
+        static constexpr unsigned kMaxBackoff = 1024;
+
+        std::atomic<bool> m_locked{ false };
+    };
+
+    // 自适应锁：先自旋等待持锁线程在短时间内释放，超过自旋次数后在 futex 上睡眠，
+    // 自旋次数按最近几次加锁实际需要的次数动态调整(同 glibc 的 PTHREAD_MUTEX_ADAPTIVE_NP)
+    // 锁状态为 0 空闲、1 已加锁、2 已加锁且可能有睡眠的线程，解锁时只有状态为 2 才需要系统调用
+    // 非 Linux 平台上以 C++20 的 std::atomic::wait 代替 futex，两者都不支持时退化为让出时间片
+    class AdaptiveMutex
+    {
+    public:
+        void lock()
+        {
+            uint32_t expected = 0;
+            if (m_state.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed))
             {
-                // 初始化对象池，创建指定数量的对象
-                for (size_t i = 0; i < initialSize; ++i)
+                return;
+            }
+            // 自旋阶段：上限为估计值的两倍再加一个常数，估计值向本次实际自旋的次数靠拢
+            int32_t estimate = m_spinEstimate.load(std::memory_order_relaxed);
+            int32_t limit = std::min(kMaxSpins, estimate * 2 + 10);
+            int32_t spins = 0;
+            for (; spins < limit; ++spins)
+            {
+                expected = 0;
+                if (m_state.load(std::memory_order_relaxed) == 0 &&
+                    m_state.compare_exchange_weak(expected, 1, std::memory_order_acquire, std::memory_order_relaxed))
                 {
-                    auto obj = createObject();
-                    m_pool.emplace_back(std::move(obj));
-                    ++m_acquiredCount;
+                    m_spinEstimate.store(estimate + (spins - estimate) / 8, std::memory_order_relaxed);
+                    return;
                 }
+                cpuRelax();
             }
-            catch (const std::bad_alloc& e)
+            m_spinEstimate.store(estimate + (spins - estimate) / 8, std::memory_order_relaxed);
+            // 睡眠阶段：把状态置为 2，交换前已经是 0 说明拿到了锁
+            while (m_state.exchange(2, std::memory_order_acquire) != 0)
             {
-                // 处理内存分配失败的异常
-                std::cerr << "Memory allocation failed: " << e.what() << std::endl;
-                throw;
+                wait(2);
             }
         }
 
-        // 创建对象的方法
-        std::unique_ptr<T> createObject()
+        bool try_lock()
         {
-            // 调用辅助函数创建对象
-            auto ptr = createObjectHelper(make_index_sequence<sizeof...(Args)>{});
-            ++m_realAllocedCount;
-            return ptr;
+            uint32_t expected = 0;
+            return m_state.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed);
         }
 
-        // 辅助函数，用于展开构造函数参数
-        template <size_t... Is>
-        std::unique_ptr<T> createObjectHelper(index_sequence<Is...>)
+        void unlock()
         {
-            // 使用元组中的参数创建对象
-            return std::unique_ptr<T>(new T(std::get<Is>(m_constructorArgs)...));
+            if (m_state.exchange(0, std::memory_order_release) == 2)
+            {
+                wake();
+            }
         }
 
-        // 释放对象的方法
-        void release(std::unique_ptr<T, CustomDeleter> ptr)
+    private:
+        // 自旋次数上限
+        static constexpr int32_t kMaxSpins = 100;
+
+        // 状态仍为 value 时睡眠
+        void wait(uint32_t value)
         {
-            // 如果对象指针为空，直接返回
-            if (!ptr) return;
+#if defined(__linux__) && defined(SYS_futex)
+            // FUTEX_WAIT | FUTEX_PRIVATE_FLAG
+            const int kFutexWaitPrivate = 128;
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_state), kFutexWaitPrivate, value, nullptr, nullptr, 0);
+#elif defined(__cpp_lib_atomic_wait)
+            m_state.wait(value, std::memory_order_relaxed);
+#else
+            (void)value;
+            std::this_thread::yield();
+#endif
+        }
 
-            // 获取原始指针
-            T* rawPtr = ptr.release();
+        // 唤醒一个睡眠的线程
+        void wake()
+        {
+#if defined(__linux__) && defined(SYS_futex)
+            // FUTEX_WAKE | FUTEX_PRIVATE_FLAG
+            const int kFutexWakePrivate = 129;
+            syscall(SYS_futex, reinterpret_cast<uint32_t*>(&m_state), kFutexWakePrivate, 1, nullptr, nullptr, 0);
+#elif defined(__cpp_lib_atomic_wait)
+            m_state.notify_one();
+#endif
+        }
 
-            // 加锁，保证对对象池的操作线程安全
-            std::lock_guard<std::mutex> lock(m_mutex);
-            if (m_releasedPtrs.count(rawPtr) > 0) return;
-            m_releasedPtrs.insert(rawPtr);
+        static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32-bit integer");
 
-            // 如果后处理函数不为空
-            if (m_postProcess)
-            {
-                // 调用后处理函数
-                m_postProcess(rawPtr);
-            }
+        std::atomic<uint32_t> m_state{ 0 };
+        // 最近几次加锁自旋次数的滑动平均
+        std::atomic<int32_t> m_spinEstimate{ 0 };
+    };
 
-            // 如果对象池的大小小于最大大小
-            if (m_pool.size() < m_maxSize)
-            {
-                // std::cout << "emplace_back" << std::endl;
-                // 将对象放回对象池
-                m_pool.emplace_back(std::unique_ptr<T>(rawPtr));
-            }
-            else
+    // acquire 延迟直方图的桶数，第 i 个桶统计耗时在 [2^i, 2^(i+1)) 纳秒内的次数
+    constexpr std::size_t kLatencyBuckets = 32;
+
+    // stats() 中一个分区的使用情况
+    struct PartitionStats
+    {
+        // 分区名称
+        std::string name;
+        // 保留给该分区的对象数量
+        std::size_t reserved = 0;
+        // 该分区最多可以持有的对象数量
+        std::size_t limit = 0;
+        // 该分区当前持有的对象数量
+        std::size_t used = 0;
+        // 其中超出保留数量、从共享名额中借用的数量
+        std::size_t borrowed = 0;
+        // 因超出配额而获取失败的次数
+        uint64_t failures = 0;
+    };
+
+    // stats() 返回的对象池统计快照，各计数器分片累加，快照之间不保证严格一致
+    struct PoolStats
+    {
+        // 成功获取的对象数量(含 acquire_n 获取的每个对象)
+        uint64_t acquires = 0;
+        // 其中从空闲列表或线程本地缓存复用的数量
+        uint64_t hits = 0;
+        // 其中因空闲列表为空而新创建的数量，不含构造时预创建的对象
+        uint64_t creates = 0;
+        // 因达到最大大小而获取失败的次数
+        uint64_t failures = 0;
+        // 释放的对象数量(含延迟回收)
+        uint64_t releases = 0;
+        // 释放时因空闲列表已满而被销毁的对象数量
+        uint64_t drops = 0;
+        // 加锁时锁已被其它线程持有的次数
+        uint64_t contendedLocks = 0;
+        // 被自适应回收销毁的空闲对象数量
+        uint64_t trimmed = 0;
+        // 当前已被获取、尚未归还的对象数量，线程本地缓存中的对象属于 available
+        std::size_t outstanding = 0;
+        // outstanding 的历史峰值
+        std::size_t peakOutstanding = 0;
+        // 当前空闲对象数量，同 getAvailableCount()
+        std::size_t available = 0;
+        // 当前存活的对象数量，同 getRealAllockedCount()
+        std::size_t allocated = 0;
+        // acquire 延迟直方图，仅在 Policy::acquireLatencyStats 为 true 时统计
+        std::array<uint64_t, kLatencyBuckets> acquireLatency{};
+        // 各分区的使用情况，按 addPartition() 返回的编号排列
+        std::vector<PartitionStats> partitions;
+    };
+
+    // 多个对象池共享的对象数量上限，用于分片对象池的全局最大大小
+    struct PoolBudget
+    {
+        explicit PoolBudget(std::size_t limit)
+            : limit(limit)
+        {
+        }
+
+        // 在上限范围内预留一个名额
+        bool tryReserve()
+        {
+            std::size_t count = used.load(std::memory_order_relaxed);
+            do
             {
-                // 如果对象池已满，且最终处理函数不为空
-                if (m_finalProcess)
+                if (count >= limit)
                 {
-                    // 调用最终处理函数
-                    m_finalProcess(rawPtr);
+                    return false;
                 }
-                // 对象会在离开作用域时自动删除
-                --m_realAllocedCount;
-                // 从跟踪集合中移除该指针
-                m_releasedPtrs.erase(rawPtr);
-                delete rawPtr;
-            }
+            } while (!used.compare_exchange_weak(count, count + 1, std::memory_order_relaxed));
+            return true;
         }
+
+        // 对象数量上限
+        const std::size_t limit;
+        // 已经预留的名额
+        std::atomic<std::size_t> used{ 0 };
+    };
+
+    // 默认的对象池策略：使用互斥锁保护的 std::vector 作为空闲列表，每个对象单独分配
+    // 自定义策略可以继承该结构体并覆盖其中的成员
+    struct DefaultPoolPolicy
+    {
+        // 是否使用无锁空闲列表代替互斥锁保护的 std::vector
+        static constexpr bool lockFree = false;
+        // 保护全局空闲列表的锁，需要提供 lock/try_lock/unlock，可选 std::mutex、SpinLock、AdaptiveMutex
+        using Mutex = std::mutex;
+        // 每个 slab 块包含的对象数量，0 表示每个对象单独分配
+        static constexpr std::size_t slabChunkSize = 0;
+        // 是否通过槽内的空闲标记检测重复释放，关闭后热路径不再访问该标记
+        static constexpr bool checkDoubleRelease = true;
+        // 编译期的预处理、后处理、最终处理函数，需要可默认构造，NoHook 表示不使用
+        using PreProcessHook = NoHook;
+        using PostProcessHook = NoHook;
+        using FinalProcessHook = NoHook;
+        // 是否支持通过 setPreProcess/setPostProcess/setFinalProcess 设置的 std::function 处理函数
+        // 关闭后热路径不再有间接调用和判空
+        static constexpr bool runtimeHooks = true;
+        // 延迟回收时间轮的槽数，每个槽对应 1 毫秒，更长的延迟在时间轮上多转几圈
+        static constexpr std::size_t delayWheelSize = 512;
+        // 对象归还时是否按 reset_traits 原地重置对象(T 带有 reset() 成员函数或特化了 reset_traits)
+        static constexpr bool resetOnRelease = true;
+        // 是否统计 stats() 中的计数器，计数器按线程分片，热路径上只多一次无竞争的原子加
+        static constexpr bool collectStats = true;
+        // 是否统计 acquire 的延迟直方图，开启后每次 acquire 多读取两次时钟
+        static constexpr bool acquireLatencyStats = false;
+        // 每个槽内为 acquire_shared() 的 std::shared_ptr 控制块预留的字节数，0 表示不支持 acquire_shared()
+        static constexpr std::size_t sharedControlBlockSize = 0;
+        // 是否把频繁写入的字段(锁与空闲列表、计数器、等待队列)各自放在独立的缓存行上，与只读的配置字段分开
+        static constexpr bool separateHotFields = false;
+        // 追踪策略，在获取命中/未命中/失败、释放、因空闲列表已满而销毁以及 clear() 时以
+        // (TraceEvent, 对象池标识, 对象地址, 调用点) 调用，需要可默认构造，NoTracer 表示不追踪
+        using Tracer = NoTracer;
+        // 每个线程每多少次追踪事件采样一次调用点，0 表示不采样(调用点为空)
+        static constexpr std::size_t traceCallSiteSampling = 0;
+        // 槽的对齐(2 的幂)，0 表示按 T 的对齐；设为 64 或 128 时相邻对象不会位于同一缓存行(或相邻行预取的一对缓存行)
+        static constexpr std::size_t objectAlignment = 0;
+        // 是否为每个 slab 块维护占用位图，支持 for_each_outstanding()/for_each_idle()，仅用于 slab 模式
+        // 开启后每次获取与释放多一次对位图字的原子读-改-写
+        static constexpr bool occupancyBitmap = false;
+    };
+
+    // 无锁对象池策略：acquire/release 的热路径不加锁，空闲数量与最大大小的判断为近似值
+    struct LockFreePoolPolicy : DefaultPoolPolicy
+    {
+        static constexpr bool lockFree = true;
+    };
+
+    // 编译期处理函数策略：处理函数作为模板参数在编译期确定，可以被内联，
+    // 不使用的处理函数为 NoHook，不占用空间；不再支持运行期设置的 std::function 处理函数
+    template <typename PreHook = NoHook, typename PostHook = NoHook, typename FinalHook = NoHook,
+        typename Base = DefaultPoolPolicy>
+    struct HookPolicy : Base
+    {
+        using PreProcessHook = PreHook;
+        using PostProcessHook = PostHook;
+        using FinalProcessHook = FinalHook;
+        static constexpr bool runtimeHooks = false;
     };
+
+    // 锁策略：用 Lock 代替 std::mutex 保护全局空闲列表，例如 LockPolicy<SpinLock>
+    template <typename Lock, typename Base = DefaultPoolPolicy>
+    struct LockPolicy : Base
+    {
+        using Mutex = Lock;
+    };
+
+    // 追踪策略：在获取、释放、销毁与 clear() 时调用 PoolTracer，每 CallSiteSampling 次事件采样一次调用点，
+    // 例如 TracePolicy<UsdtTracer, 64>
+    template <typename PoolTracer, std::size_t CallSiteSampling = 0, typename Base = DefaultPoolPolicy>
+    struct TracePolicy : Base
+    {
+        using Tracer = PoolTracer;
+        static constexpr std::size_t traceCallSiteSampling = CallSiteSampling;
+    };
+
+    // 支持 acquire_shared() 的对象池策略，控制块与对象放在同一个槽内
+    // 64 字节足以容纳 libstdc++、libc++ 与 MSVC 的带删除器和分配器的控制块，放不下时编译报错
+    struct SharedPoolPolicy : DefaultPoolPolicy
+    {
+        static constexpr std::size_t sharedControlBlockSize = 64;
+    };
+
+    // 按缓存行布局的对象池策略：频繁写入的字段各自独占缓存行，每个对象按缓存行对齐并补齐，
+    // 由不同线程使用的相邻对象之间不会发生伪共享
+    struct CacheAlignedPoolPolicy : DefaultPoolPolicy
+    {
+        static constexpr bool separateHotFields = true;
+        static constexpr std::size_t objectAlignment = kCacheLineSize;
+    };
+
+    // slab 对象池策略：对象连续地构造在按缓存行对齐的大块内存中，按块增长
+    struct SlabPoolPolicy : DefaultPoolPolicy
+    {
+        static constexpr std::size_t slabChunkSize = 64;
+    };
+
+    // 带占用位图的 slab 对象池策略：支持 for_each_outstanding()/for_each_idle()，
+    // 代价是每次获取与释放多一次对位图字的原子读-改-写
+    struct SlabBitmapPoolPolicy : SlabPoolPolicy
+    {
+        static constexpr bool occupancyBitmap = true;
+    };
+
+    // 检测类型是否派生自 std::enable_shared_from_this
+    template <typename T, typename = void>
+    struct is_shared_from_this : std::false_type
+    {
+    };
+
+    template <typename T>
+    struct is_shared_from_this<T, std::void_t<decltype(std::declval<T&>().weak_from_this())>> : std::true_type
+    {
+    };
+
+    // 槽内为 acquire_shared() 预留的控制块存储，Size 为 0 时是空类型，位于槽的填充字节中，不增加槽的大小
+    template <std::size_t Size>
+    struct SharedControlArea
+    {
+        alignas(std::max_align_t) unsigned char storage[Size];
+    };
+
+    template <>
+    struct SharedControlArea<0>
+    {
+    };
+
+    // 保存一个编译期处理函数，Index 用于区分同一类型的多个处理函数，空的处理函数通过空基类优化不占用空间
+    template <typename Hook, int Index>
+    struct HookHolder : Hook
+    {
+        Hook& hook()
+        {
+            return *this;
+        }
+    };
+
+    // 保存策略中的三个编译期处理函数与追踪策略
+    template <typename Policy>
+    struct PolicyHooks
+        : HookHolder<typename Policy::PreProcessHook, 0>,
+        HookHolder<typename Policy::PostProcessHook, 1>,
+        HookHolder<typename Policy::FinalProcessHook, 2>,
+        HookHolder<typename Policy::Tracer, 3>
+    {
+    };
+
+    // 定义对象池模板类，T 是对象的类型，Policy 是对象池策略，Args 是对象构造函数的参数类型
+    template <typename T, typename Policy, typename... Args>
+    class BasicObjectPool : public std::enable_shared_from_this<BasicObjectPool<T, Policy, Args...>>,
+        private PolicyHooks<Policy>
+    {
+    public:
+        // 定义预处理函数类型，用于在获取对象前对对象进行处理
+        using PreProcess = std::function<void(T*)>;
+        // 定义后处理函数类型，用于在释放对象后对对象进行处理
+        using PostProcess = std::function<void(T*)>;
+        // 定义最终处理函数类型，用于在对象被销毁前对对象进行处理
+        using FinalProcess = std::function<void(T*)>;
+        // 保护全局空闲列表的锁类型
+        using Mutex = typename Policy::Mutex;
+        static_assert((Policy::objectAlignment & (Policy::objectAlignment - 1)) == 0, "Policy::objectAlignment must be a power of two");
+        static_assert(!Policy::occupancyBitmap || Policy::slabChunkSize > 0, "Policy::occupancyBitmap requires slab storage (Policy::slabChunkSize > 0)");
+    public:
+        // 自定义删除器结构体，用于在对象释放时将其放回对象池
+        // 删除器不含任何成员，通过对象所在槽中的回指找到所属对象池，
+        // 因此 std::unique_ptr<T, CustomDeleter> 与裸指针大小相同
+        struct CustomDeleter
+        {
+            // 重载函数调用运算符，当对象被删除时调用
+            void operator()(T* ptr) const
+            {
+                // 对象池在仍有对象未归还时会保持自身存活，这里可以直接访问
+                slotOf(ptr)->pool->release(std::unique_ptr<T, CustomDeleter>(ptr));
+            }
+        };
+
+        // acquire_shared() 的删除器：引用计数归零时什么也不做，对象在控制块释放时才回到对象池，
+        // 因此仍有 std::weak_ptr 指向控制块时，对象与控制块所在的槽不会被复用
+        struct SharedDeleter
+        {
+            void operator()(T*) const
+            {
+            }
+        };
+
+        // acquire_shared() 的分配器：控制块构造在对象所在槽的预留存储中，控制块释放时把对象归还给对象池
+        template <typename U>
+        struct SharedAllocator
+        {
+            using value_type = U;
+
+            explicit SharedAllocator(T* ptr)
+                : object(ptr)
+            {
+            }
+
+            template <typename V>
+            SharedAllocator(const SharedAllocator<V>& other)
+                : object(other.object)
+            {
+            }
+
+            // std::shared_ptr 只会为控制块分配一次，每次一个
+            U* allocate(size_t)
+            {
+                static_assert(sizeof(U) <= Policy::sharedControlBlockSize && alignof(U) <= alignof(std::max_align_t),
+                    "std::shared_ptr control block does not fit in Policy::sharedControlBlockSize");
+                return reinterpret_cast<U*>(slotOf(object)->control.storage);
+            }
+
+            // 控制块已经析构，对象回到对象池，之后槽可以被复用
+            void deallocate(U*, size_t)
+            {
+                CustomDeleter()(object);
+            }
+
+            template <typename V>
+            bool operator==(const SharedAllocator<V>& other) const
+            {
+                return object == other.object;
+            }
+
+            template <typename V>
+            bool operator!=(const SharedAllocator<V>& other) const
+            {
+                return object != other.object;
+            }
+
+            // 控制块所管理的对象
+            T* object;
+        };
+
+        struct Chunk;
+        struct ThreadCache;
+
+        // 槽内记录的分区编号：对象未计入任何分区，或计入所有分区共享的名额(不指定分区获取)
+        static constexpr uint32_t kUncharged = std::numeric_limits<uint32_t>::max();
+        static constexpr uint32_t kSharedPartition = kUncharged - 1;
+
+        // 对象槽，对象通过 placement new 构造在槽内，槽内同时保存空闲列表所需的链接信息
+        struct Slot
+        {
+            // 对象存储，位于槽的起始位置，因此 T* 与 Slot* 可以互相转换；按 Policy::objectAlignment 对齐时槽的大小随之补齐
+            alignas(Policy::objectAlignment > alignof(T) ? Policy::objectAlignment : alignof(T)) unsigned char storage[sizeof(T)];
+            // 无锁空闲列表(或远程释放列表)中的下一个槽
+            std::atomic<Slot*> next{ nullptr };
+            // 对象是否空闲(位于空闲列表或线程本地缓存中)，用于检测重复释放
+            std::atomic<bool> idle{ false };
+            // acquire_shared() 的控制块存储
+            SharedControlArea<Policy::sharedControlBlockSize> control;
+            // 对象计入的分区，释放时据此归还配额
+            uint32_t partition{ kUncharged };
+            // 槽所在的 slab 块，单独分配的槽为空指针
+            Chunk* chunk{ nullptr };
+            // 槽所属的对象池
+            BasicObjectPool* pool{ nullptr };
+            // 获取对象的线程的本地缓存，其它线程释放时对象压入它的远程释放列表，未经过线程本地缓存获取时为空指针
+            ThreadCache* owner{ nullptr };
+
+            // 获取槽内的对象
+            T* object()
+            {
+                return reinterpret_cast<T*>(storage);
+            }
+        };
+
+        // slab 块，块头之后紧跟 capacity 个连续的槽，开启占用位图时槽之后是 live 与 outstanding 两个位图
+        struct Chunk
+        {
+            // 块内槽的数量
+            size_t capacity{ 0 };
+
+            // 获取块内的第一个槽
+            Slot* slots()
+            {
+                return reinterpret_cast<Slot*>(reinterpret_cast<unsigned char*>(this) + kChunkHeaderSize);
+            }
+
+            // 每个位图的字数
+            size_t bitmapWords() const
+            {
+                return (capacity + 63) / 64;
+            }
+
+            // 获取占用位图，kLiveBitmap 的位表示槽内有存活的对象，kOutstandingBitmap 的位表示对象已被获取
+            std::atomic<uint64_t>* bitmap(size_t which)
+            {
+                return reinterpret_cast<std::atomic<uint64_t>*>(reinterpret_cast<unsigned char*>(this) + kChunkHeaderSize
+                    + capacity * sizeof(Slot)) + which * bitmapWords();
+            }
+        };
+
+        // 占用位图的编号
+        static constexpr size_t kLiveBitmap = 0;
+        static constexpr size_t kOutstandingBitmap = 1;
+
+        // slab 块的对齐，至少按缓存行对齐
+        static constexpr size_t kChunkAlignment = alignof(Slot) > kCacheLineSize ? alignof(Slot) : kCacheLineSize;
+        // slab 块头所占的字节数，保证第一个槽按块的对齐方式对齐
+        static constexpr size_t kChunkHeaderSize = (sizeof(Chunk) + kChunkAlignment - 1) / kChunkAlignment * kChunkAlignment;
+
+        // 线程本地缓存(magazine)，位于全局空闲列表之前
+        struct ThreadCache
+        {
+            // 缓存的空闲对象，只由所属线程访问
+            std::vector<T*> objects;
+            // 缓存中的对象数量，供其它线程统计空闲数量时读取
+            std::atomic<size_t> count{ 0 };
+            // 本线程获取(计入缓存)与释放的对象数量之差，按 2^64 取模，跨线程释放时可以为"负"
+            // 只由所属线程修改，对象池被用户放弃时由 detach() 并入 m_outstanding
+            std::atomic<size_t> outstanding{ 0 };
+            // 批量归还时复用的缓冲区
+            std::vector<T*> flushing;
+            // 远程释放列表：其它线程释放本线程获取的对象时用一次 CAS 压入，本地缓存为空时由所属线程一次取走
+            // 所属线程退出后为 closedRemoteFree()，此后释放的对象改走全局空闲列表；与所属线程修改的字段分开存放
+            alignas(kCacheLineSize) std::atomic<Slot*> remoteFree{ nullptr };
+        };
+
+        // 远程释放列表已关闭的标记
+        static Slot* closedRemoteFree()
+        {
+            return reinterpret_cast<Slot*>(uintptr_t{ 1 });
+        }
+
+        int getRealAllockedCount()
+        {
+            return m_realAllocedCount;
+        }
+
+        // 静态工厂方法，用于创建对象池的共享指针
+        static std::shared_ptr<BasicObjectPool> create(
+            // 对象池的初始大小，默认为 10
+            size_t initialSize = 10,
+            // 对象池的最大大小，默认为 size_t 类型的最大值
+            size_t maxSize = std::numeric_limits<size_t>::max(),
+            // 对象构造函数的参数
+            Args&&... args)
+        {
+            // 创建对象池的共享指针
+            auto pool = std::shared_ptr<BasicObjectPool>(new BasicObjectPool(
+                initialSize, maxSize, std::forward<Args>(args)...), Retire());
+            return pool;
+        }
+
+        // 静态工厂方法，对象存储(包括 slab 块)与空闲列表等簿记结构都从 resource 分配，
+        // 例如大页内存、共享内存或 std::pmr::monotonic_buffer_resource；resource 需要比对象池活得更久
+        static std::shared_ptr<BasicObjectPool> createWithResource(
+            std::pmr::memory_resource* resource,
+            size_t initialSize = 10,
+            size_t maxSize = std::numeric_limits<size_t>::max(),
+            Args&&... args)
+        {
+            return std::shared_ptr<BasicObjectPool>(new BasicObjectPool(
+                std::allocator_arg, resource, initialSize, maxSize, std::forward<Args>(args)...), Retire());
+        }
+
+        // 静态工厂方法，与 create() 相同，但 initialSize 个初始对象由 threads 个线程并行创建，
+        // 用于构造耗时的对象(TLS 上下文、大缓冲区等)；任何一个对象创建失败时抛出该异常
+        static std::shared_ptr<BasicObjectPool> createParallel(
+            size_t initialSize,
+            size_t maxSize,
+            size_t threads,
+            Args&&... args)
+        {
+            auto pool = create(0, maxSize, std::forward<Args>(args)...);
+            pool->prewarm(initialSize, threads).get();
+            return pool;
+        }
+
+        // 设置预处理函数
+        void setPreProcess(PreProcess preProcess)
+        {
+            static_assert(Policy::runtimeHooks, "runtime hooks are disabled by the pool policy");
+            m_preProcess = preProcess;
+        }
+
+        // 设置后处理函数
+        void setPostProcess(PostProcess postProcess)
+        {
+            static_assert(Policy::runtimeHooks, "runtime hooks are disabled by the pool policy");
+            m_postProcess = postProcess;
+        }
+
+        // 设置最终处理函数
+        void setFinalProcess(FinalProcess finalProcess)
+        {
+            static_assert(Policy::runtimeHooks, "runtime hooks are disabled by the pool policy");
+            m_finalProcess = finalProcess;
+            // 更新自定义删除器中的最终处理函数
+            for (const auto& ptr : m_pool)
+            {
+                // 这里不需要额外处理，因为删除器在对象归还时才会起作用
+            }
+        }
+
+        // 设置线程本地缓存的深度，0 表示关闭(默认)
+        // 开启后 acquire/release 优先在线程本地完成，只有本地缓存为空或已满时
+        // 才加锁与全局空闲列表成批交换对象(每批为深度的一半)
+        // 仅对通过 create() 创建的对象池生效
+        void setThreadCacheSize(size_t depth)
+        {
+            m_threadCacheSize = depth;
+        }
+
+        // 与其它对象池共享一个对象数量上限，此后新建对象同时受 maxSize 与该上限限制
+        // 需要在对象池创建任何对象之前调用，已有的对象不计入该上限
+        void setBudget(std::shared_ptr<PoolBudget> budget)
+        {
+            m_budget = std::move(budget);
+        }
+
+        // 设置对象池所属的 NUMA 节点，之后分配的 slab 块优先从该节点分配物理页
+        // 非 slab 模式下对象单独分配，只能依赖首次访问的线程所在节点
+        void setNumaNode(size_t node)
+        {
+            std::lock_guard<std::mutex> lock(m_slabMutex);
+            m_numaNode = static_cast<int>(node);
+        }
+
+        // 设置自适应回收策略：统计每个时间窗口内全局空闲列表的最低水位，
+        // 窗口结束时最低水位仍高于 minIdle，说明多出的对象整个窗口内都没有被用到，将其销毁
+        // window 为 0 时不自动结束窗口，由用户(例如后台维护线程)定期调用 trim()
+        // 开启后 acquire/release 走全局空闲列表时会多读取一次时钟；线程本地缓存中的对象不会被回收
+        void setTrimPolicy(std::chrono::milliseconds window, size_t minIdle = 0)
+        {
+            m_trimMinIdle = minIdle;
+            m_trimWindow = window.count() > 0 ? static_cast<uint64_t>(window.count()) : 0;
+            m_trimLowWater.store(m_availableCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            m_trimWindowStart.store(delayTick(), std::memory_order_relaxed);
+            m_trimEnabled = true;
+        }
+
+        // 立即结束当前窗口并按最低水位回收空闲对象，返回销毁的对象数量
+        // 未调用 setTrimPolicy() 时什么也不做
+        size_t trim()
+        {
+            if (!m_trimEnabled)
+            {
+                return 0;
+            }
+            m_trimWindowStart.store(delayTick(), std::memory_order_relaxed);
+            return endTrimWindow();
+        }
+
+        // 添加一个分区并返回分区编号，用于多个调用方共用一个对象池时保护优先级高的调用方
+        // 分区始终可以持有 reserved 个对象，其它调用方无法占用这部分名额；超出的部分从共享名额
+        // (maxSize 减去所有分区的 reserved)中借用，最多持有 limit 个
+        // 添加分区后不指定分区的获取只能使用共享名额；需要在获取对象之前调用，
+        // 所有分区的 reserved 之和超过 maxSize 或 reserved 大于 limit 时抛出 std::invalid_argument
+        size_t addPartition(std::string name, size_t reserved, size_t limit = std::numeric_limits<size_t>::max())
+        {
+            if (reserved > limit || reserved > m_sharedCapacity || m_partitions.size() >= kSharedPartition)
+            {
+                throw std::invalid_argument("cppobjectpool: partition reservation exceeds the pool capacity");
+            }
+            auto partition = std::make_unique<Partition>();
+            partition->name = std::move(name);
+            partition->reserved = reserved;
+            partition->limit = limit;
+            m_partitions.push_back(std::move(partition));
+            m_sharedCapacity -= reserved;
+            return m_partitions.size() - 1;
+        }
+
+        // 设置全局空闲列表的低水位与高水位：空闲对象少于 low 时在锁外成批创建对象，直到达到 high，
+        // 使 acquire() 几乎总能命中空闲列表；low 为 0 时关闭
+        // background 为 true 时由后台补充线程在 acquire 发现低于低水位时补充(仅对通过 create() 创建的对象池生效)，
+        // 否则由用户(例如事件循环或维护线程)定期调用 maintain()
+        void setWatermarks(size_t low, size_t high, bool background = true)
+        {
+            m_refillLow = low;
+            m_refillHigh = std::max(low, high);
+            if (background && low != 0 && !m_refill)
+            {
+                std::weak_ptr<BasicObjectPool> weak = this->weak_from_this();
+                if (!weak.expired())
+                {
+                    auto state = std::make_shared<RefillState>();
+                    std::thread(&BasicObjectPool::refillWorker, std::move(weak), state).detach();
+                    m_refill = std::move(state);
+                }
+            }
+            checkWatermark();
+        }
+
+        // 空闲对象少于低水位时补充到高水位，返回新建的对象数量；未设置水位时什么也不做
+        // 对象在锁外成批创建，每批的数量从 1 开始逐批加倍，每批之后重新读取空闲数量，
+        // 达到最大大小时停止；同一时刻只有一个调用者在补充，创建失败时抛出该异常
+        size_t maintain()
+        {
+            if (m_refillLow == 0 || m_availableCount.load(std::memory_order_relaxed) >= m_refillLow)
+            {
+                return 0;
+            }
+            if (m_refilling.exchange(true, std::memory_order_acquire))
+            {
+                return 0;
+            }
+            size_t created = 0;
+            try
+            {
+                for (size_t batch = 1;; batch *= 2)
+                {
+                    size_t available = m_availableCount.load(std::memory_order_relaxed);
+                    if (available >= m_refillHigh)
+                    {
+                        break;
+                    }
+                    size_t n = std::min(batch, m_refillHigh - available);
+                    size_t made = createIdle(n);
+                    created += made;
+                    if (made < n)
+                    {
+                        break;
+                    }
+                }
+            }
+            catch (...)
+            {
+                m_refilling.store(false, std::memory_order_release);
+                throw;
+            }
+            m_refilling.store(false, std::memory_order_release);
+            return created;
+        }
+
+        // 在最大大小范围内预先创建 count 个对象并放入空闲列表，返回实际创建的数量
+        // slab 模式下这些对象一次性分配在同一块内存中；不调用预处理/后处理函数，也不计入 stats() 的 creates
+        size_t reserve(size_t count)
+        {
+            reserveSlots(count);
+            return createIdle(count);
+        }
+
+        // 在后台用 threads 个线程把对象池中的对象总数补充到 target(不超过最大大小)，立即返回
+        // 补充期间对象池照常提供服务，返回的 future 在补充结束后给出新建的对象数量，创建失败时给出该异常；
+        // 补充线程只在创建一批对象期间持有对象池的强引用，用户释放对象池的全部引用后补充随之结束。仅对通过 create() 创建的对象池生效
+        std::shared_future<size_t> prewarm(size_t target, size_t threads = 1)
+        {
+            threads = std::max<size_t>(threads, 1);
+            auto state = std::make_shared<WarmState>();
+            std::shared_future<size_t> future = state->done.get_future().share();
+            {
+                std::lock_guard<std::mutex> lock(m_warmMutex);
+                m_warm = future;
+            }
+            target = std::min(target, m_maxSize);
+            size_t current = m_acquiredCount.load(std::memory_order_relaxed);
+            size_t pending = target > current ? target - current : 0;
+            state->pending.store(pending, std::memory_order_relaxed);
+            state->running.store(threads, std::memory_order_relaxed);
+            // slab 模式下需要的槽在调用线程上一次性分配，补充线程只负责构造对象
+            reserveSlots(pending);
+            std::weak_ptr<BasicObjectPool> weak = this->weak_from_this();
+            size_t started = 0;
+            try
+            {
+                for (; started < threads; ++started)
+                {
+                    std::thread(&BasicObjectPool::warmWorker, weak, state).detach();
+                }
+            }
+            catch (const std::system_error&)
+            {
+                // 无法创建更多线程时由已经启动的线程完成补充，一个线程都没有启动时在当前线程上补充
+                for (size_t i = started; i < threads; ++i)
+                {
+                    if (started == 0 && i == 0)
+                    {
+                        warmWorker(weak, state);
+                    }
+                    else
+                    {
+                        finishWarmWorker(*state);
+                    }
+                }
+            }
+            return future;
+        }
+
+        // 等待最近一次 prewarm() 结束，返回其新建的对象数量，补充失败时抛出该异常；未调用过 prewarm() 时返回 0
+        size_t awaitWarm()
+        {
+            std::shared_future<size_t> future;
+            {
+                std::lock_guard<std::mutex> lock(m_warmMutex);
+                future = m_warm;
+            }
+            return future.valid() ? future.get() : 0;
+        }
+
+        // 析构函数，用于清理对象池
+        ~BasicObjectPool()
+        {
+            // 通知后台补充线程退出，析构可能就发生在补充线程上，它返回后会看到退出标记
+            if (m_refill)
+            {
+                std::lock_guard<std::mutex> lock(m_refill->mutex);
+                m_refill->stopped = true;
+                m_refill->cv.notify_all();
+            }
+            // 同样通知时间轮定时器线程退出
+            if (m_delayTimer)
+            {
+                std::lock_guard<std::mutex> lock(m_delayTimer->mutex);
+                m_delayTimer->stopped = true;
+                m_delayTimer->cv.notify_all();
+            }
+            // 销毁所有线程本地缓存中的对象
+            // 此时已没有线程持有对象池的强引用，不会再有线程访问这些缓存
+            {
+                std::lock_guard<Mutex> lock(m_mutex);
+                for (auto& cache : m_threadCaches)
+                {
+                    closeRemoteFree(*cache);
+                    for (T* ptr : cache->objects)
+                    {
+                        destroyObject(ptr);
+                    }
+                    // 线程本地表中的表项要到下标被复用或线程退出时才释放缓存，先释放其中的数组
+                    std::vector<T*>().swap(cache->objects);
+                    std::vector<T*>().swap(cache->flushing);
+                    cache->count.store(0, std::memory_order_relaxed);
+                }
+                m_threadCaches.clear();
+            }
+            // 清空对象池
+            clear();
+            // 归还 slab 块与保留槽的内存
+            releaseChunks();
+            // 线程本地表中的下标留给之后创建的对象池
+            releaseCacheIndex(m_cacheIndex);
+        }
+
+        // 获取对象的方法，返回一个智能指针
+        std::unique_ptr<T, CustomDeleter> acquire()
+        {
+            return acquireImpl([this] { return createObject(); }, [](T*) {}, kSharedPartition, sampleCallSite(CPPOBJECTPOOL_CALL_SITE()));
+        }
+
+        // 使用调用方提供的构造参数获取对象：需要新建对象时直接构造 T(args...)，
+        // 复用空闲对象时析构后在原来的存储中构造 T(args...)，存储不会被释放；
+        // 构造抛出异常时回收该槽，异常继续向外传播
+        template <typename First, typename... Rest>
+        std::unique_ptr<T, CustomDeleter> acquire(First&& first, Rest&&... rest)
+        {
+            // make 与 init 只会调用其中一个，参数只会被转发一次
+            bool created = false;
+            return acquireImpl(
+                [&] {
+                    created = true;
+                    return emplaceObject(std::forward<First>(first), std::forward<Rest>(rest)...);
+                },
+                [&](T* ptr) {
+                    if (created) return;
+                    // 析构期间不能被 for_each_outstanding() 访问，构造成功后重新出现在位图中
+                    clearLive(ptr);
+                    ptr->~T();
+                    new (ptr) T(std::forward<First>(first), std::forward<Rest>(rest)...);
+                    updateOccupancy(ptr, kLiveBitmap, true);
+                },
+                kSharedPartition, sampleCallSite(CPPOBJECTPOOL_CALL_SITE()));
+        }
+
+        // 从 addPartition() 返回的分区获取对象，超出分区配额或达到最大大小时返回空指针
+        // 分区配额在获取时按原子计数检查，热路径上不加锁
+        std::unique_ptr<T, CustomDeleter> acquire_partition(size_t partition)
+        {
+            if (partition >= m_partitions.size())
+            {
+                throw std::out_of_range("cppobjectpool: unknown partition");
+            }
+            return acquireImpl([this] { return createObject(); }, [](T*) {}, static_cast<uint32_t>(partition),
+                sampleCallSite(CPPOBJECTPOOL_CALL_SITE()));
+        }
+
+        // acquire() 的实现，先按分区配额计费，获取失败时归还配额，获取成功时在槽内记录分区
+        template <typename Make, typename Init>
+        std::unique_ptr<T, CustomDeleter> acquireImpl(Make&& make, Init&& init, uint32_t partition, const void* callSite)
+        {
+            if (m_partitions.empty())
+            {
+                return acquireObject(make, init, callSite);
+            }
+            // 超出配额时与达到最大大小一样获取失败
+            if (!chargePartition(partition))
+            {
+                countStat(&StatShard::failures);
+                trace(TraceEvent::AcquireFail, nullptr, callSite);
+                return nullptr;
+            }
+            std::unique_ptr<T, CustomDeleter> obj;
+            try
+            {
+                obj = acquireObject(make, init, callSite);
+            }
+            catch (...)
+            {
+                unchargePartition(partition);
+                throw;
+            }
+            if (obj)
+            {
+                slotOf(obj.get())->partition = partition;
+            }
+            else
+            {
+                unchargePartition(partition);
+            }
+            return obj;
+        }
+
+        // 获取一个对象，空闲列表为空时通过 make 新建对象，
+        // init 在对象标记为已获取之后、预处理函数之前调用；callSite 为追踪事件中的调用点
+        template <typename Make, typename Init>
+        std::unique_ptr<T, CustomDeleter> acquireObject(Make&& make, Init&& init, const void* callSite)
+        {
+            // 区分复用与新建，用于追踪事件
+            bool created = false;
+            auto create = [&] {
+                created = true;
+                return make();
+            };
+            // 构造失败归还计数时对象池可能已被用户放弃，见 detach()
+            std::shared_ptr<BasicObjectPool> keepAlive;
+            std::chrono::steady_clock::time_point begin;
+            if constexpr (Policy::acquireLatencyStats)
+            {
+                begin = std::chrono::steady_clock::now();
+            }
+            T* ptr = nullptr;
+            // 优先从线程本地缓存中获取对象
+            ThreadCache* cache = localThreadCache();
+            if (cache)
+            {
+                // 本地缓存为空时，先取回其它线程释放的对象，仍为空时从全局空闲列表批量补充
+                if (cache->objects.empty())
+                {
+                    drainRemoteFree(*cache);
+                }
+                if (cache->objects.empty())
+                {
+                    refillThreadCache(*cache);
+                }
+                if (!cache->objects.empty())
+                {
+                    ptr = cache->objects.back();
+                    cache->objects.pop_back();
+                    cache->count.store(cache->objects.size(), std::memory_order_relaxed);
+                }
+            }
+
+            // 本地缓存未命中时，走全局路径
+            if (!ptr)
+            {
+                // 先回收已到期的延迟回收对象
+                processDelayed();
+                ptr = acquireFromPool(create);
+                // 已达到最大大小时，取回滞留在其它线程远程释放列表中的对象后再试一次
+                if (!ptr && cache)
+                {
+                    reclaimRemoteFree();
+                    ptr = acquireFromPool(create);
+                }
+                adaptTrim();
+                checkWatermark();
+            }
+
+            // 交给调用方的对象计入已获取数量，开启线程本地缓存时计在本线程的缓存中，不修改共享的计数；
+            // 线程本地缓存中的空闲对象不计入
+            if (ptr)
+            {
+                addOutstanding(1, cache);
+                if (created)
+                {
+                    samplePeak();
+                }
+            }
+
+            // 将取出的对象标记为已获取，并记录获取它的线程
+            if (ptr)
+            {
+                markAcquired(ptr, cache);
+                try
+                {
+                    init(ptr);
+                }
+                catch (...)
+                {
+                    // 槽内已经没有存活的对象，直接回收该槽
+                    discardSlot(ptr);
+                    keepAlive = removeOutstanding(1, cache);
+                    throw;
+                }
+            }
+
+            // 如果成功获取到对象，调用预处理函数
+            if (ptr)
+            {
+                preProcess(ptr);
+            }
+
+            countStat(ptr ? &StatShard::acquires : &StatShard::failures);
+            if constexpr (Policy::acquireLatencyStats)
+            {
+                recordAcquireLatency(begin);
+            }
+            trace(ptr ? (created ? TraceEvent::AcquireMiss : TraceEvent::AcquireHit) : TraceEvent::AcquireFail, ptr, callSite);
+
+            // 返回一个智能指针，使用自定义删除器
+            return std::unique_ptr<T, CustomDeleter>(ptr);
+        }
+
+        // 获取共享所有权的对象，控制块构造在对象所在的槽内，获取时不分配内存
+        // 最后一个 std::shared_ptr 与 std::weak_ptr 都释放后对象才回到对象池；需要策略的 sharedControlBlockSize 不为 0
+        std::shared_ptr<T> acquire_shared()
+        {
+            static_assert(Policy::sharedControlBlockSize > 0, "acquire_shared() requires Policy::sharedControlBlockSize > 0, e.g. SharedPoolPolicy");
+            // 对象内的 weak_this 会让控制块永远不被释放，对象也就永远回不到对象池
+            static_assert(!is_shared_from_this<T>::value, "acquire_shared() does not support std::enable_shared_from_this types");
+            T* ptr = acquireImpl([this] { return createObject(); }, [](T*) {}, kSharedPartition,
+                sampleCallSite(CPPOBJECTPOOL_CALL_SITE())).release();
+            if (!ptr)
+            {
+                return nullptr;
+            }
+            return std::shared_ptr<T>(ptr, SharedDeleter(), SharedAllocator<T>(ptr));
+        }
+
+        // 获取对象，达到最大大小时阻塞等待，直到有对象被释放
+        // 等待的线程按先来先得的顺序排队，每次释放只唤醒一个等待者并把对象直接交给它
+        std::unique_ptr<T, CustomDeleter> acquire_wait()
+        {
+            return waitForObject(nullptr, sampleCallSite(CPPOBJECTPOOL_CALL_SITE()));
+        }
+
+        // 获取对象，达到最大大小时最多等待 timeout，超时返回空指针
+        template <typename Rep, typename Period>
+        std::unique_ptr<T, CustomDeleter> try_acquire_for(const std::chrono::duration<Rep, Period>& timeout)
+        {
+            auto deadline = std::chrono::steady_clock::now() +
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+            return waitForObject(&deadline, sampleCallSite(CPPOBJECTPOOL_CALL_SITE()));
+        }
+
+#if defined(CPPOBJECTPOOL_COROUTINES)
+        class AcquireAwaiter;
+
+        // 在协程中获取对象：co_await pool->acquire_async()，达到最大大小时挂起协程而不阻塞线程
+        // 与 acquire_wait() 共用同一个先进先出等待队列，等待节点位于协程帧中，挂起不分配内存；
+        // 协程由归还对象的线程在归还过程中恢复，等待期间需保证对象池存活
+        AcquireAwaiter acquire_async()
+        {
+            return AcquireAwaiter(*this, nullptr, nullptr, sampleCallSite(CPPOBJECTPOOL_CALL_SITE()));
+        }
+
+        // 同上，但协程通过 executor(std::coroutine_handle<>) 恢复，由执行器决定在哪个线程上运行
+        // 执行器在等待期间需保持存活，调用时不能抛出异常
+        template <typename Executor>
+        AcquireAwaiter acquire_async(Executor& executor)
+        {
+            return AcquireAwaiter(*this, &executor, [](void* context, std::coroutine_handle<> handle) {
+                (*static_cast<Executor*>(context))(handle);
+            }, sampleCallSite(CPPOBJECTPOOL_CALL_SITE()));
+        }
+#endif
+
+        // 批量获取对象，最多获取 count 个，依次写入 out，返回实际获取的数量
+        // 只加锁一次从空闲列表末尾取出连续的一段对象，不足的部分在最大大小范围内创建，
+        // 预处理函数在锁外对整批对象执行；批量接口不经过线程本地缓存
+        template <typename OutputIt>
+        size_t acquire_n(size_t count, OutputIt out)
+        {
+            const void* callSite = sampleCallSite(CPPOBJECTPOOL_CALL_SITE());
+            std::shared_ptr<BasicObjectPool> keepAlive;
+            std::vector<T*> batch = takeBatchBuffer();
+            // 添加分区后批量获取的对象同样计入共享名额，批次大小以借到的名额为限
+            size_t charged = borrowSharedUpTo(count);
+            // 批次中前 reused 个对象来自空闲列表，其余为新建的对象
+            size_t reused = 0;
+            if constexpr (Policy::lockFree)
+            {
+                while (batch.size() < charged)
+                {
+                    Slot* slot = popFreeSlot();
+                    if (!slot) break;
+                    batch.push_back(slot->object());
+                }
+                reused = batch.size();
+                while (batch.size() < charged && reserveObject())
+                {
+                    try
+                    {
+                        batch.push_back(createObject());
+                        countStat(&StatShard::creates);
+                    }
+                    catch (...)
+                    {
+                        keepAlive = abandonBatch(batch, reused, charged);
+                        throw;
+                    }
+                }
+            }
+            else
+            {
+                // 加锁，保证线程安全
+                std::unique_lock<Mutex> lock = lockPool();
+                // 从对象池的末尾取出一段连续的对象
+                size_t n = std::min(charged, m_pool.size());
+                batch.insert(batch.end(), m_pool.end() - n, m_pool.end());
+                m_pool.resize(m_pool.size() - n);
+                m_availableCount.store(m_pool.size(), std::memory_order_relaxed);
+                reused = n;
+                // 对象池中的对象不足时，在最大大小范围内创建新对象，构造在锁外进行
+                lock.unlock();
+                while (batch.size() < charged && reserveObject())
+                {
+                    try
+                    {
+                        batch.push_back(createObject());
+                    }
+                    catch (...)
+                    {
+                        keepAlive = abandonBatch(batch, reused, charged);
+                        throw;
+                    }
+                    countStat(&StatShard::creates);
+                }
+            }
+            addOutstanding(batch.size());
+            adaptTrim();
+            checkWatermark();
+            countStat(&StatShard::acquires, batch.size());
+            countStat(&StatShard::failures, count - batch.size());
+            returnShared(charged - batch.size());
+
+            for (size_t i = 0; i < batch.size(); ++i)
+            {
+                T* ptr = batch[i];
+                markAcquired(ptr);
+                if (!m_partitions.empty())
+                {
+                    slotOf(ptr)->partition = kSharedPartition;
+                }
+                // 调用预处理函数
+                preProcess(ptr);
+                trace(i < reused ? TraceEvent::AcquireHit : TraceEvent::AcquireMiss, ptr, callSite);
+                *out = std::unique_ptr<T, CustomDeleter>(ptr);
+                ++out;
+            }
+            size_t n = batch.size();
+            returnBatchBuffer(std::move(batch));
+            return n;
+        }
+
+        // 批量释放对象，range 中的元素为 acquire()/acquire_n() 返回的智能指针，释放后均为空
+        // 后处理函数在锁外对整批对象执行，之后只加锁一次把整批对象放回空闲列表
+        template <typename Range>
+        void release_n(Range&& range)
+        {
+            const void* callSite = sampleCallSite(CPPOBJECTPOOL_CALL_SITE());
+            std::shared_ptr<BasicObjectPool> keepAlive;
+            std::vector<T*> batch = takeBatchBuffer();
+            for (auto& ptr : range)
+            {
+                T* rawPtr = ptr.release();
+                // 跳过空指针和重复释放的对象
+                if (!rawPtr || !markReleased(rawPtr)) continue;
+                // 调用后处理函数
+                postProcess(rawPtr);
+                batch.push_back(rawPtr);
+            }
+            countStat(&StatShard::releases, batch.size());
+            keepAlive = releaseBatch(batch, true, true, callSite);
+            returnBatchBuffer(std::move(batch));
+        }
+
+        // 获取对象池中空闲对象的数量
+        // 未开启线程本地缓存时不加锁，直接读取空闲列表的计数
+        size_t getAvailableCount() const
+        {
+            size_t count = m_availableCount.load(std::memory_order_relaxed);
+            if (m_threadCacheSize == 0)
+            {
+                return count;
+            }
+            // 加锁，保证线程安全
+            std::lock_guard<Mutex> lock(m_mutex);
+            // 线程本地缓存中的对象同样是空闲对象
+            for (const auto& cache : m_threadCaches)
+            {
+                count += cache->count.load(std::memory_order_relaxed);
+            }
+            return count;
+        }
+
+        // 获取对象池的统计快照，用于根据实际负载确定 initialSize/maxSize
+        // Policy::collectStats 为 false 时计数器均为 0
+        PoolStats stats() const
+        {
+            PoolStats result;
+            for (const StatShard& shard : m_statShards)
+            {
+                result.acquires += shard.acquires.load(std::memory_order_relaxed);
+                result.creates += shard.creates.load(std::memory_order_relaxed);
+                result.failures += shard.failures.load(std::memory_order_relaxed);
+                result.releases += shard.releases.load(std::memory_order_relaxed);
+                result.drops += shard.drops.load(std::memory_order_relaxed);
+                result.contendedLocks += shard.contendedLocks.load(std::memory_order_relaxed);
+                result.trimmed += shard.trimmed.load(std::memory_order_relaxed);
+                for (size_t i = 0; i < kLatencyBuckets; ++i)
+                {
+                    result.acquireLatency[i] += shard.acquireLatency[i].load(std::memory_order_relaxed);
+                }
+            }
+            // 各分片分别读取，创建数可能先于获取数被计入
+            result.hits = result.acquires > result.creates ? result.acquires - result.creates : 0;
+            result.outstanding = outstandingCount();
+            samplePeak(result.outstanding);
+            result.peakOutstanding = m_peakOutstanding.load(std::memory_order_relaxed);
+            result.available = getAvailableCount();
+            result.allocated = m_realAllocedCount.load(std::memory_order_relaxed);
+            for (const auto& partition : m_partitions)
+            {
+                PartitionStats p;
+                p.name = partition->name;
+                p.reserved = partition->reserved;
+                p.limit = partition->limit;
+                p.used = partition->used.load(std::memory_order_relaxed);
+                p.borrowed = p.used > p.reserved ? p.used - p.reserved : 0;
+                p.failures = partition->failures.load(std::memory_order_relaxed);
+                result.partitions.push_back(std::move(p));
+            }
+            return result;
+        }
+
+        // 按内存顺序访问所有已被获取的对象，对每个对象调用 fn(T&)，返回访问的数量
+        // 逐字扫描每个 slab 块的占用位图，不做哈希也不复制快照；需要策略的 occupancyBitmap 为 true
+        // 扫描期间持有 slab 锁，被访问的对象不会被销毁，但其它线程照常获取与释放对象：
+        // fn 需要自行与使用对象的线程同步，且不能调用本对象池的接口
+        template <typename Func>
+        size_t for_each_outstanding(Func&& fn)
+        {
+            return forEachOccupied(fn, true);
+        }
+
+        // 同上，访问所有空闲对象，包括全局空闲列表、线程本地缓存与延迟回收时间轮中的对象
+        template <typename Func>
+        size_t for_each_idle(Func&& fn)
+        {
+            return forEachOccupied(fn, false);
+        }
+
+        // 回收已到期的延迟回收对象，返回回收的数量
+        // acquire() 未命中线程本地缓存时和 release(obj, delay) 会自动调用，
+        // 也可以在事件循环中定期调用，使到期的对象及时回到空闲列表
+        size_t processDelayed()
+        {
+            if (m_delayedCount.load(std::memory_order_relaxed) == 0)
+            {
+                return 0;
+            }
+            std::vector<T*> batch = takeBatchBuffer();
+            {
+                std::lock_guard<std::mutex> lock(m_delayMutex);
+                uint64_t now = delayTick();
+                if (now > m_delayCursor)
+                {
+                    // 从上次推进的位置走到当前时刻，距离超过一圈时每个槽只需扫描一次
+                    uint64_t steps = std::min<uint64_t>(now - m_delayCursor, m_delayWheel.size());
+                    for (uint64_t i = 1; i <= steps; ++i)
+                    {
+                        auto& bucket = m_delayWheel[(m_delayCursor + i) % m_delayWheel.size()];
+                        for (size_t j = 0; j < bucket.size();)
+                        {
+                            // 未到期的对象还需要再转若干圈
+                            if (bucket[j].deadline > now)
+                            {
+                                ++j;
+                                continue;
+                            }
+                            batch.push_back(bucket[j].ptr);
+                            bucket[j] = bucket.back();
+                            bucket.pop_back();
+                        }
+                    }
+                    m_delayCursor = now;
+                    m_delayedCount.fetch_sub(batch.size(), std::memory_order_relaxed);
+                }
+            }
+            for (T* ptr : batch)
+            {
+                // 到期时才调用后处理函数，延迟期间对象可能仍在被异步操作使用
+                postProcess(ptr);
+            }
+            // 延迟回收对象已不计入 m_outstanding，放回空闲列表时不再减少计数
+            releaseBatch(batch, false);
+            size_t n = batch.size();
+            returnBatchBuffer(std::move(batch));
+            return n;
+        }
+
+        // 清空对象池
+        // 开启线程本地缓存时，只会清空调用线程自己的缓存，其它线程的缓存在线程退出或对象池析构时清理
+        // 对象在锁外销毁，最终处理函数和析构函数不会阻塞其它线程
+        void clear()
+        {
+            trace(TraceEvent::Clear, nullptr, sampleCallSite(CPPOBJECTPOOL_CALL_SITE()));
+            std::vector<T*> objects;
+            // 取出当前线程的本地缓存，本地缓存只由当前线程访问，不需要加锁
+            if (ThreadCache* cache = findThreadCache())
+            {
+                drainRemoteFree(*cache);
+                objects.swap(cache->objects);
+                cache->count.store(0, std::memory_order_relaxed);
+            }
+            // 取出所有尚未到期的延迟回收对象，它们不计入 m_outstanding
+            {
+                std::lock_guard<std::mutex> lock(m_delayMutex);
+                for (auto& bucket : m_delayWheel)
+                {
+                    for (const DelayedEntry& entry : bucket)
+                    {
+                        objects.push_back(entry.ptr);
+                    }
+                    bucket.clear();
+                }
+                m_delayedCount.store(0, std::memory_order_relaxed);
+            }
+            // 无锁空闲列表一次取出全部对象
+            if constexpr (Policy::lockFree)
+            {
+                Slot* slot = m_freeList.popAll();
+                while (slot)
+                {
+                    Slot* next = slot->next.load(std::memory_order_relaxed);
+                    m_availableCount.fetch_sub(1, std::memory_order_relaxed);
+                    objects.push_back(slot->object());
+                    slot = next;
+                }
+            }
+            {
+                // 加锁，保证对对象池的操作线程安全
+                std::lock_guard<Mutex> lock(m_mutex);
+                // 取出对象池中的所有对象
+                objects.insert(objects.end(), m_pool.begin(), m_pool.end());
+                // 清空对象池
+                m_pool.clear();
+                if constexpr (!Policy::lockFree)
+                {
+                    m_availableCount.store(0, std::memory_order_relaxed);
+                }
+            }
+            for (T* ptr : objects)
+            {
+                // 调用最终处理函数并销毁对象
+                destroyObject(ptr);
+            }
+        }
+
+        // 频繁写入的字段组的对齐，Policy::separateHotFields 为 false 时为 U 本身的对齐；
+        // 每组的第一个字段与紧随该组的字段都按它对齐，使该组独占缓存行
+        template <typename U>
+        static constexpr size_t kHotFieldAlignment = Policy::separateHotFields && alignof(U) < kCacheLineSize ? kCacheLineSize : alignof(U);
+
+        // 对象存储、slab 块与空闲列表等簿记结构使用的内存资源，需要比对象池活得更久
+        std::pmr::memory_resource* m_resource{ std::pmr::get_default_resource() };
+        // 保护对象池的锁(Policy::Mutex)，与空闲列表一起独占缓存行
+        alignas(kHotFieldAlignment<Mutex>) mutable Mutex m_mutex;
+        // 存储空闲对象的向量，对象由对象池负责销毁
+        std::pmr::vector<T*> m_pool{ m_resource };
+        // 无锁空闲列表，仅在 Policy::lockFree 为 true 时使用
+        LockFreeStack<Slot> m_freeList;
+        // 全局空闲列表中的对象数量，互斥锁模式下在锁内更新，无锁模式下为近似值
+        std::atomic<size_t> m_availableCount{ 0 };
+        // 保护 slab 块与未使用槽列表的互斥锁
+        alignas(kHotFieldAlignment<std::mutex>) std::mutex m_slabMutex;
+        // 对象池分配的所有 slab 块
+        std::pmr::vector<Chunk*> m_chunks{ m_resource };
+        // slab 块中尚未构造对象的槽
+        Slot* m_rawSlots{ nullptr };
+        // 新分配的 slab 块绑定的 NUMA 节点，-1 表示不绑定
+        int m_numaNode{ -1 };
+        // 对象池仍被用户持有时 m_outstanding 中额外计入的数量，使计数在用户放弃对象池之前不会归零
+        static constexpr size_t kAttached = size_t{ 1 } << (std::numeric_limits<size_t>::digits - 1);
+        // 不经过线程本地缓存计数的已被获取对象数量(其余计在各线程本地缓存中)，另加 kAttached
+        alignas(kHotFieldAlignment<std::atomic<size_t>>) std::atomic<size_t> m_outstanding{ kAttached };
+        // 已被获取对象数量的历史峰值，采样得到
+        mutable std::atomic<size_t> m_peakOutstanding{ 0 };
+        // 用户已经释放对象池的最后一个强引用，此后最后一个归还的对象析构对象池
+        std::atomic<bool> m_detached{ false };
+        // 以下为构造后只读的配置，单独成组，不与上面的计数及下面的对象数量计数共享缓存行
+        // 对象池的最大大小
+        alignas(kHotFieldAlignment<size_t>) size_t m_maxSize;
+        // 预处理函数
+        PreProcess m_preProcess;
+        // 后处理函数
+        PostProcess m_postProcess;
+        // 最终处理函数
+        FinalProcess m_finalProcess;
+        // 与其它对象池共享的对象数量上限，为空表示只受 m_maxSize 限制
+        std::shared_ptr<PoolBudget> m_budget;
+        // 已分配的对象数量(随回收变化)
+        alignas(kHotFieldAlignment<std::atomic<size_t>>) std::atomic<size_t> m_acquiredCount{ 0 };
+        // 分配过的对象数量
+        std::atomic<size_t> m_realAllocedCount{ 0 };
+        // 存储对象构造函数参数的元组
+        alignas(kHotFieldAlignment<std::tuple<Args...>>) std::tuple<Args...> m_constructorArgs;
+        // 线程本地缓存的深度，0 表示不使用线程本地缓存
+        size_t m_threadCacheSize{ 0 };
+        // 所有线程的本地缓存，用于统计空闲数量和析构时清理
+        std::vector<std::shared_ptr<ThreadCache>> m_threadCaches;
+        // 对象池的唯一标识，用于追踪事件与识别线程本地表中的过期表项
+        const uint64_t m_poolId{ nextPoolId() };
+        // 本对象池的缓存在线程本地表中的下标，存活的对象池之间互不相同
+        const uint32_t m_cacheIndex{ acquireCacheIndex() };
+
+        // stats() 的一个计数器分片，每个线程固定使用其中一个，分片之间按缓存行隔开
+        struct alignas(kCacheLineSize) StatShard
+        {
+            std::atomic<uint64_t> acquires{ 0 };
+            std::atomic<uint64_t> creates{ 0 };
+            std::atomic<uint64_t> failures{ 0 };
+            std::atomic<uint64_t> releases{ 0 };
+            std::atomic<uint64_t> drops{ 0 };
+            std::atomic<uint64_t> contendedLocks{ 0 };
+            std::atomic<uint64_t> trimmed{ 0 };
+            std::atomic<uint64_t> acquireLatency[kLatencyBuckets] = {};
+        };
+
+        // 计数器分片的数量
+        static constexpr size_t kStatShards = Policy::collectStats ? 16 : 1;
+        // 统计计数器分片
+        std::array<StatShard, kStatShards> m_statShards;
+
+        // 时间轮中的一个延迟回收对象
+        struct DelayedEntry
+        {
+            // 等待回收的对象
+            T* ptr;
+            // 到期时刻，单位为时间轮的刻度(毫秒)
+            uint64_t deadline;
+        };
+
+        // 保护延迟回收时间轮的互斥锁
+        std::mutex m_delayMutex;
+        // 延迟回收时间轮，每个槽存放到期刻度对槽数取模相同的对象，首次延迟回收时分配
+        std::pmr::vector<std::pmr::vector<DelayedEntry>> m_delayWheel{ m_resource };
+        // 时间轮已经处理到的刻度
+        uint64_t m_delayCursor{ 0 };
+        // 时间轮的起始时刻
+        const std::chrono::steady_clock::time_point m_delayEpoch{ std::chrono::steady_clock::now() };
+        // 时间轮中等待回收的对象数量
+        std::atomic<size_t> m_delayedCount{ 0 };
+
+        // 等待队列中的一个节点，位于等待线程的栈上或等待协程的协程帧中
+        struct Waiter
+        {
+            // 交给等待者的对象
+            T* object{ nullptr };
+            // 是否已被移出等待队列并交出对象
+            bool ready{ false };
+            // 是否在等待队列中
+            bool queued{ false };
+            Waiter* prev{ nullptr };
+            Waiter* next{ nullptr };
+            // 异步等待者收到对象后的恢复函数，在释放 m_waitMutex 之后调用；同步等待者为空
+            void (*resume)(Waiter&){ nullptr };
+        };
+
+        // 阻塞等待的线程
+        struct SyncWaiter : Waiter
+        {
+            // 唤醒该线程的条件变量
+            std::condition_variable cv;
+        };
+
+#if defined(CPPOBJECTPOOL_COROUTINES)
+        // acquire_async() 返回的等待体，自身就是等待队列中的节点
+        class AcquireAwaiter : private Waiter
+        {
+        public:
+            using Schedule = void (*)(void*, std::coroutine_handle<>);
+
+            AcquireAwaiter(BasicObjectPool& pool, void* executor, Schedule schedule, const void* callSite)
+                : m_pool(pool), m_executor(executor), m_schedule(schedule), m_callSite(callSite)
+            {
+                this->resume = &AcquireAwaiter::resumeCoroutine;
+            }
+
+            AcquireAwaiter(const AcquireAwaiter&) = delete;
+            AcquireAwaiter& operator=(const AcquireAwaiter&) = delete;
+
+            // 挂起的协程被销毁时把节点移出等待队列，已经交来、尚未取走的对象还给对象池
+            // 交出对象的线程调用恢复函数(或执行器)之前不能销毁协程
+            ~AcquireAwaiter()
+            {
+                // 没有挂起过的等待体从未入队
+                if (!m_handle)
+                {
+                    return;
+                }
+                std::unique_lock<std::mutex> lock(m_pool.m_waitMutex);
+                if (this->queued)
+                {
+                    m_pool.removeWaiter(*this);
+                    return;
+                }
+                T* object = this->ready ? this->object : nullptr;
+                lock.unlock();
+                if (object)
+                {
+                    m_pool.giveBack(object);
+                }
+            }
+
+            // 能立即获取到对象时不挂起
+            bool await_ready()
+            {
+                m_result = m_pool.acquire();
+                return m_result != nullptr;
+            }
+
+            // 加入等待队列后再尝试一次，覆盖释放方没有看到等待者的情况；返回 false 表示不挂起
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                m_handle = handle;
+                std::unique_lock<std::mutex> lock(m_pool.m_waitMutex);
+                m_pool.enqueueWaiter(*this);
+                // 协程不会像阻塞等待的线程那样按刻度轮询，由定时器推进时间轮，使对象到期后交给等待者
+                if (m_pool.m_delayedCount.load(std::memory_order_relaxed) != 0)
+                {
+                    m_pool.armDelayTimer();
+                }
+                lock.unlock();
+                auto ptr = m_pool.acquire();
+                lock.lock();
+                if (this->ready)
+                {
+                    // 已经收到对象，协程随时可能在其它线程上恢复，此后不能再访问协程帧；
+                    // 多拿到的对象由 ptr 析构时归还
+                    lock.unlock();
+                    return true;
+                }
+                if (ptr)
+                {
+                    m_pool.removeWaiter(*this);
+                    lock.unlock();
+                    m_result = std::move(ptr);
+                    return false;
+                }
+                return true;
+            }
+
+            // 返回获取到的对象
+            std::unique_ptr<T, CustomDeleter> await_resume()
+            {
+                if (!m_result)
+                {
+                    m_result = m_pool.takeHandedOff(this->object, m_callSite);
+                    this->object = nullptr;
+                }
+                return std::move(m_result);
+            }
+
+        private:
+            friend class BasicObjectPool;
+
+            // 收到对象后由交出对象的线程调用，恢复后等待体可能已被销毁
+            static void resumeCoroutine(Waiter& waiter)
+            {
+                AcquireAwaiter& self = static_cast<AcquireAwaiter&>(waiter);
+                if (self.m_schedule)
+                {
+                    self.m_schedule(self.m_executor, self.m_handle);
+                }
+                else
+                {
+                    self.m_handle.resume();
+                }
+            }
+
+            BasicObjectPool& m_pool;
+            // 恢复协程的执行器，为空时直接在交出对象的线程上恢复
+            void* m_executor;
+            Schedule m_schedule;
+            // 追踪事件中的调用点
+            const void* m_callSite;
+            std::coroutine_handle<> m_handle;
+            std::unique_ptr<T, CustomDeleter> m_result;
+        };
+#endif
+
+        // 保护等待队列的互斥锁
+        alignas(kHotFieldAlignment<std::mutex>) std::mutex m_waitMutex;
+        // 等待对象的线程组成的先进先出队列
+        Waiter* m_waitHead{ nullptr };
+        Waiter* m_waitTail{ nullptr };
+        // 等待队列中的线程数量，释放方据此决定是否直接交出对象
+        std::atomic<size_t> m_waiterCount{ 0 };
+        // serveWaiters() 已预留共享名额、正在锁外为其取对象的等待者数量，由 m_waitMutex 保护
+        size_t m_servingCount{ 0 };
+
+        // 保护 m_warm 的互斥锁
+        alignas(kHotFieldAlignment<std::mutex>) std::mutex m_warmMutex;
+        // 最近一次 prewarm() 的结果
+        std::shared_future<size_t> m_warm;
+
+        // 后台补充线程的共享状态，由对象池与补充线程共同持有，对象池析构后补充线程仍可以安全访问
+        struct RefillState
+        {
+            std::mutex mutex;
+            std::condition_variable cv;
+            // 有 acquire 发现空闲对象低于低水位
+            bool requested{ false };
+            // 对象池已经析构
+            bool stopped{ false };
+        };
+
+        // 时间轮定时器线程的共享状态，由对象池与定时器线程共同持有
+        struct DelayTimerState
+        {
+            std::mutex mutex;
+            std::condition_variable cv;
+            // 有异步等待者在等待时间轮中的对象到期
+            bool armed{ false };
+            // 对象池已经析构
+            bool stopped{ false };
+        };
+
+        // 时间轮定时器线程的共享状态，首次需要时启动，由 m_waitMutex 保护
+        std::shared_ptr<DelayTimerState> m_delayTimer;
+
+        // 全局空闲列表的低水位与高水位，低水位为 0 表示不补充
+        size_t m_refillLow{ 0 };
+        size_t m_refillHigh{ 0 };
+        // 后台补充线程的共享状态，未开启后台补充时为空
+        std::shared_ptr<RefillState> m_refill;
+        // 已经唤醒后台补充线程、补充尚未结束
+        alignas(kHotFieldAlignment<std::atomic<bool>>) std::atomic<bool> m_refillPending{ false };
+        // 正在执行 maintain()
+        std::atomic<bool> m_refilling{ false };
+
+        // 是否开启自适应回收
+        bool m_trimEnabled{ false };
+        // 自适应回收的窗口长度(毫秒)，0 表示只在调用 trim() 时结束窗口
+        uint64_t m_trimWindow{ 0 };
+        // 回收后至少保留的空闲对象数量
+        size_t m_trimMinIdle{ 0 };
+        // 当前窗口的起始刻度
+        alignas(kHotFieldAlignment<std::atomic<uint64_t>>) std::atomic<uint64_t> m_trimWindowStart{ 0 };
+        // 当前窗口内全局空闲列表的最低水位
+        std::atomic<size_t> m_trimLowWater{ 0 };
+
+        // 一个分区的配额与使用量
+        struct Partition
+        {
+            std::string name;
+            // 保留给该分区的对象数量
+            size_t reserved{ 0 };
+            // 该分区最多可以持有的对象数量
+            size_t limit{ 0 };
+            // 该分区当前持有的对象数量，与其它分区的计数位于不同的缓存行
+            alignas(kCacheLineSize) std::atomic<size_t> used{ 0 };
+            // 因超出配额而获取失败的次数
+            std::atomic<uint64_t> failures{ 0 };
+        };
+
+        // 所有分区，添加后不再移除
+        std::vector<std::unique_ptr<Partition>> m_partitions;
+        // 共享名额：maxSize 减去所有分区的 reserved
+        size_t m_sharedCapacity{ m_maxSize };
+        // 已经借出的共享名额(不指定分区获取的对象，以及各分区超出 reserved 的对象)
+        alignas(kHotFieldAlignment<std::atomic<size_t>>) std::atomic<size_t> m_sharedUsed{ 0 };
+
+        // 线程本地表中的一项，记录某个对象池在当前线程的缓存
+        struct ThreadCacheEntry
+        {
+            // 对象池的唯一标识，0 表示空表项
+            uint64_t poolId{ 0 };
+            // 弱引用指向对象池，线程退出时用于归还缓存中的对象
+            std::weak_ptr<BasicObjectPool> pool;
+            // 当前线程的缓存
+            std::shared_ptr<ThreadCache> cache;
+        };
+
+        // 线程本地表，按对象池的 m_cacheIndex 直接索引，线程退出时将缓存中的对象归还给仍然存活的对象池
+        // 下标在对象池析构后被新的对象池复用，表项的 poolId 与之不同时视为过期，由新的对象池覆盖
+        struct ThreadCacheTable
+        {
+            std::vector<ThreadCacheEntry> entries;
+            ~ThreadCacheTable()
+            {
+                for (auto& entry : entries)
+                {
+                    // 对象池已销毁(或表项为空)时，缓存中的对象已由对象池的析构函数清理
+                    if (auto pool = entry.pool.lock())
+                    {
+                        pool->closeRemoteFree(*entry.cache);
+                        pool->flushThreadCache(*entry.cache, entry.cache->objects.size());
+                    }
+                }
+            }
+        };
+
+        // 生成对象池的唯一标识
+        static uint64_t nextPoolId()
+        {
+            static std::atomic<uint64_t> id{ 0 };
+            return ++id;
+        }
+
+        // 线程本地表下标的分配器，回收已析构对象池的下标，使表的长度不超过同时存活的对象池数量
+        struct CacheIndexRegistry
+        {
+            std::mutex mutex;
+            std::vector<uint32_t> freed;
+            uint32_t next{ 0 };
+        };
+
+        static CacheIndexRegistry& cacheIndexRegistry()
+        {
+            static CacheIndexRegistry registry;
+            return registry;
+        }
+
+        // 为新的对象池分配线程本地表中的下标，优先复用已回收的下标
+        static uint32_t acquireCacheIndex()
+        {
+            CacheIndexRegistry& registry = cacheIndexRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            if (registry.freed.empty())
+            {
+                return registry.next++;
+            }
+            uint32_t index = registry.freed.back();
+            registry.freed.pop_back();
+            return index;
+        }
+
+        // 回收析构的对象池的下标
+        static void releaseCacheIndex(uint32_t index)
+        {
+            CacheIndexRegistry& registry = cacheIndexRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.freed.push_back(index);
+        }
+
+        // 获取当前线程的线程本地表
+        static ThreadCacheTable& threadCacheTable()
+        {
+            static thread_local ThreadCacheTable table;
+            return table;
+        }
+
+        // 查找当前线程在本对象池中的缓存，不存在时返回空指针；按下标直接定位，不做线性查找
+        ThreadCache* findThreadCache()
+        {
+            auto& entries = threadCacheTable().entries;
+            if (m_cacheIndex < entries.size() && entries[m_cacheIndex].poolId == m_poolId)
+            {
+                return entries[m_cacheIndex].cache.get();
+            }
+            return nullptr;
+        }
+
+        // 获取当前线程在本对象池中的缓存，首次使用时注册
+        // 未开启线程本地缓存或对象池不是通过 create() 创建时返回空指针
+        ThreadCache* localThreadCache()
+        {
+            if (m_threadCacheSize == 0)
+            {
+                return nullptr;
+            }
+            if (ThreadCache* cache = findThreadCache())
+            {
+                return cache;
+            }
+
+            auto self = this->weak_from_this();
+            if (self.expired())
+            {
+                return nullptr;
+            }
+
+            auto& entries = threadCacheTable().entries;
+            if (m_cacheIndex >= entries.size())
+            {
+                entries.resize(m_cacheIndex + 1);
+            }
+
+            std::shared_ptr<ThreadCache> cache;
+            {
+                std::lock_guard<Mutex> lock(m_mutex);
+                // 复用已退出线程留下的缓存；仍在外的对象可能记录着这些缓存，因此缓存在对象池析构前不会被释放，
+                // 复用后这些对象被释放时回到新线程的缓存
+                auto it = std::find_if(m_threadCaches.begin(), m_threadCaches.end(),
+                    [](const std::shared_ptr<ThreadCache>& c) { return c.use_count() == 1; });
+                if (it != m_threadCaches.end())
+                {
+                    cache = *it;
+                    cache->remoteFree.store(nullptr, std::memory_order_relaxed);
+                }
+                else
+                {
+                    cache = std::make_shared<ThreadCache>();
+                    m_threadCaches.push_back(cache);
+                }
+            }
+            cache->objects.reserve(m_threadCacheSize);
+            // 覆盖下标相同、已析构的对象池留下的过期表项
+            entries[m_cacheIndex] = ThreadCacheEntry{ m_poolId, std::move(self), cache };
+            return cache.get();
+        }
+
+        // 每次与全局空闲列表交换的对象数量
+        size_t threadCacheBatch() const
+        {
+            return std::max<size_t>(1, m_threadCacheSize / 2);
+        }
+
+        // 从全局空闲列表批量补充线程本地缓存，返回补充的对象数量
+        size_t refillThreadCache(ThreadCache& cache)
+        {
+            size_t n = 0;
+            if constexpr (Policy::lockFree)
+            {
+                for (; n < threadCacheBatch(); ++n)
+                {
+                    Slot* slot = popFreeSlot();
+                    if (!slot) break;
+                    cache.objects.push_back(slot->object());
+                }
+            }
+            else
+            {
+                std::unique_lock<Mutex> lock = lockPool();
+                n = std::min(threadCacheBatch(), m_pool.size());
+                for (size_t i = 0; i < n; ++i)
+                {
+                    T* ptr = m_pool.back();
+                    m_pool.pop_back();
+                    cache.objects.push_back(ptr);
+                }
+                m_availableCount.store(m_pool.size(), std::memory_order_relaxed);
+            }
+            cache.count.store(cache.objects.size(), std::memory_order_relaxed);
+            adaptTrim();
+            checkWatermark();
+            // 经线程本地缓存的获取不更新峰值，缓存耗尽时采样一次
+            samplePeak();
+            return n;
+        }
+
+        // 把对象压入所属线程的远程释放列表，列表已关闭(所属线程已退出)时返回 false
+        static bool pushRemoteFree(ThreadCache& owner, Slot* slot)
+        {
+            Slot* head = owner.remoteFree.load(std::memory_order_relaxed);
+            do
+            {
+                if (head == closedRemoteFree())
+                {
+                    return false;
+                }
+                slot->next.store(head, std::memory_order_relaxed);
+            } while (!owner.remoteFree.compare_exchange_weak(head, slot, std::memory_order_release, std::memory_order_relaxed));
+            return true;
+        }
+
+        // 把远程释放列表中的对象一次取回本地缓存，超出缓存深度的部分归还给全局空闲列表
+        void drainRemoteFree(ThreadCache& cache)
+        {
+            // 列表为空时不做读-改-写操作；列表只由所属线程关闭，检查之后不会变为关闭状态
+            Slot* head = cache.remoteFree.load(std::memory_order_relaxed);
+            if (head == nullptr || head == closedRemoteFree())
+            {
+                return;
+            }
+            takeRemoteFree(cache, cache.remoteFree.exchange(nullptr, std::memory_order_acquire));
+            if (cache.objects.size() > m_threadCacheSize)
+            {
+                flushThreadCache(cache, cache.objects.size() - m_threadCacheSize);
+            }
+        }
+
+        // 取走所有线程远程释放列表中的对象并归还给全局空闲列表，
+        // 避免对象滞留在不再获取对象的线程中；只在对象池已达到最大大小时调用
+        void reclaimRemoteFree()
+        {
+            std::vector<T*> batch;
+            {
+                std::lock_guard<Mutex> lock(m_mutex);
+                for (auto& cache : m_threadCaches)
+                {
+                    // 已关闭的列表保持关闭状态
+                    Slot* slot = cache->remoteFree.load(std::memory_order_relaxed);
+                    while (slot != nullptr && slot != closedRemoteFree()
+                        && !cache->remoteFree.compare_exchange_weak(slot, nullptr, std::memory_order_acquire, std::memory_order_relaxed))
+                    {
+                    }
+                    for (; slot != nullptr && slot != closedRemoteFree(); slot = slot->next.load(std::memory_order_relaxed))
+                    {
+                        batch.push_back(slot->object());
+                    }
+                }
+            }
+            // 远程释放列表中的对象已经归还，不计入 m_outstanding
+            releaseBatch(batch, false);
+        }
+
+        // 所属线程退出或对象池析构时关闭远程释放列表，并把其中的对象取回本地缓存
+        static void closeRemoteFree(ThreadCache& cache)
+        {
+            takeRemoteFree(cache, cache.remoteFree.exchange(closedRemoteFree(), std::memory_order_acquire));
+        }
+
+        // 把从远程释放列表取下的一串槽放入本地缓存
+        static void takeRemoteFree(ThreadCache& cache, Slot* slot)
+        {
+            if (slot == closedRemoteFree())
+            {
+                return;
+            }
+            while (slot)
+            {
+                Slot* next = slot->next.load(std::memory_order_relaxed);
+                cache.objects.push_back(slot->object());
+                slot = next;
+            }
+            cache.count.store(cache.objects.size(), std::memory_order_relaxed);
+        }
+
+        // 将线程本地缓存中最早放入的 n 个对象批量归还给全局空闲列表，缓存中的对象不计入 m_outstanding
+        void flushThreadCache(ThreadCache& cache, size_t n)
+        {
+            n = std::min(n, cache.objects.size());
+            // 先把要归还的对象移出本地缓存，归还过程中回调函数再次访问本地缓存也不会受影响
+            std::vector<T*> batch;
+            batch.swap(cache.flushing);
+            batch.assign(cache.objects.begin(), cache.objects.begin() + n);
+            cache.objects.erase(cache.objects.begin(), cache.objects.begin() + n);
+            cache.count.store(cache.objects.size(), std::memory_order_relaxed);
+            adaptTrim();
+            // 空闲列表放不下的对象在锁外销毁
+            releaseBatch(batch, false);
+            batch.clear();
+            cache.flushing.swap(batch);
+        }
+
+        // 把一批已执行过后处理的对象放回全局空闲列表，超出最大大小的部分被销毁
+        // outstanding 为 false 表示这批对象不计入 m_outstanding(来自延迟回收时间轮或线程本地缓存)
+        // traceRelease 为 true 时(用户释放)为回到对象池的对象发出 Release 事件，调用点为 callSite
+        std::shared_ptr<BasicObjectPool> releaseBatch(const std::vector<T*>& batch, bool outstanding = true,
+            bool traceRelease = false, const void* callSite = nullptr)
+        {
+            if (batch.empty())
+            {
+                return nullptr;
+            }
+            // 优先直接交给正在等待的线程，这部分对象仍不在全局空闲列表中
+            size_t handed = m_waiterCount.load(std::memory_order_relaxed) != 0
+                ? handOffBatch(batch, outstanding, traceRelease, callSite) : 0;
+            size_t count = batch.size() - handed;
+            if constexpr (Policy::lockFree)
+            {
+                // 把放得下的对象链接成一串，用一次 CAS 压入无锁空闲列表
+                size_t available = m_availableCount.load(std::memory_order_relaxed);
+                size_t room = available < m_maxSize ? m_maxSize - available : 0;
+                size_t n = std::min(room, count);
+                for (size_t i = handed; i < handed + n; ++i)
+                {
+                    if (traceRelease)
+                    {
+                        trace(TraceEvent::Release, batch[i], callSite);
+                    }
+                    slotOf(batch[i])->next.store(i + 1 < handed + n ? slotOf(batch[i + 1]) : nullptr, std::memory_order_relaxed);
+                }
+                if (n > 0)
+                {
+                    m_availableCount.fetch_add(n, std::memory_order_relaxed);
+                    m_freeList.pushChain(slotOf(batch[handed]), slotOf(batch[handed + n - 1]));
+                }
+                for (size_t i = handed + n; i < batch.size(); ++i)
+                {
+                    // 空闲列表已满，销毁对象
+                    trace(TraceEvent::Drop, batch[i], callSite);
+                    destroyObject(batch[i]);
+                }
+                countStat(&StatShard::drops, count - n);
+            }
+            else
+            {
+                size_t n = 0;
+                {
+                    // 加锁，保证对对象池的操作线程安全
+                    std::unique_lock<Mutex> lock = lockPool();
+                    size_t room = m_pool.size() < m_maxSize ? m_maxSize - m_pool.size() : 0;
+                    n = std::min(room, count);
+                    for (size_t i = handed; traceRelease && i < handed + n; ++i)
+                    {
+                        trace(TraceEvent::Release, batch[i], callSite);
+                    }
+                    // 将一段连续的对象放回对象池
+                    m_pool.insert(m_pool.end(), batch.begin() + handed, batch.begin() + handed + n);
+                    m_availableCount.store(m_pool.size(), std::memory_order_relaxed);
+                }
+                countStat(&StatShard::drops, count - n);
+                for (size_t i = handed + n; i < batch.size(); ++i)
+                {
+                    // 对象池已满，在锁外销毁对象
+                    trace(TraceEvent::Drop, batch[i], callSite);
+                    destroyObject(batch[i]);
+                }
+            }
+            // 放回空闲列表之后才出现的等待者
+            if (hasWaiters())
+            {
+                serveWaiters();
+            }
+            // 对象全部处理完后才减少计数，此后不再访问对象池
+            return outstanding ? removeOutstanding(count) : nullptr;
+        }
+
+        // 把等待者加入等待队列的末尾，调用方需持有 m_waitMutex
+        void enqueueWaiter(Waiter& waiter)
+        {
+            waiter.ready = false;
+            waiter.queued = true;
+            waiter.object = nullptr;
+            waiter.next = nullptr;
+            waiter.prev = m_waitTail;
+            (m_waitTail ? m_waitTail->next : m_waitHead) = &waiter;
+            m_waitTail = &waiter;
+            m_waiterCount.fetch_add(1, std::memory_order_relaxed);
+            // 与 hasWaiters() 中的栅栏配对：释放方要么看到这个等待者，要么等待者入队后的重新尝试看到释放方放回的对象
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+
+        // 对象放回空闲列表、线程本地缓存或被销毁之后检查是否有等待者，与 enqueueWaiter() 中的栅栏配对
+        bool hasWaiters() const
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            return m_waiterCount.load(std::memory_order_relaxed) != 0;
+        }
+
+        // 唤醒所有阻塞等待的线程，使其按延迟回收时间轮的刻度重新尝试获取；有异步等待者时启动时间轮定时器
+        void pollWaiters()
+        {
+            std::lock_guard<std::mutex> lock(m_waitMutex);
+            bool async = false;
+            for (Waiter* waiter = m_waitHead; waiter; waiter = waiter->next)
+            {
+                if (!waiter->resume)
+                {
+                    static_cast<SyncWaiter*>(waiter)->cv.notify_one();
+                }
+                else
+                {
+                    async = true;
+                }
+            }
+            if (async)
+            {
+                armDelayTimer();
+            }
+        }
+
+        // 让定时器线程在下一个刻度推进时间轮，到期的对象经 releaseBatch() 直接交给等待者；调用方需持有 m_waitMutex
+        // 定时器线程首次需要时启动，仅对通过 create() 创建的对象池生效；
+        // 无法启动时退化为由下一次 acquire() 或延迟回收推进时间轮
+        void armDelayTimer()
+        {
+            if (!m_delayTimer)
+            {
+                std::weak_ptr<BasicObjectPool> weak = this->weak_from_this();
+                if (weak.expired())
+                {
+                    return;
+                }
+                auto state = std::make_shared<DelayTimerState>();
+                try
+                {
+                    std::thread(&BasicObjectPool::delayTimerWorker, std::move(weak), state).detach();
+                }
+                catch (const std::system_error&)
+                {
+                    return;
+                }
+                m_delayTimer = std::move(state);
+            }
+            std::lock_guard<std::mutex> lock(m_delayTimer->mutex);
+            m_delayTimer->armed = true;
+            m_delayTimer->cv.notify_one();
+        }
+
+        // 时间轮定时器线程，被唤醒后每个刻度临时持有对象池的强引用并调用 processDelayed()，
+        // 直到等待队列为空或时间轮中没有对象
+        static void delayTimerWorker(std::weak_ptr<BasicObjectPool> weak, std::shared_ptr<DelayTimerState> state)
+        {
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(state->mutex);
+                    state->cv.wait(lock, [&] { return state->armed || state->stopped; });
+                    // 等待一个刻度，使时间轮中的对象有机会到期
+                    state->cv.wait_for(lock, std::chrono::milliseconds(1), [&] { return state->stopped; });
+                    if (state->stopped)
+                    {
+                        return;
+                    }
+                    state->armed = false;
+                }
+                // 强引用在这里释放时可能析构对象池，析构函数会设置退出标记
+                std::shared_ptr<BasicObjectPool> pool = weak.lock();
+                if (!pool)
+                {
+                    return;
+                }
+                pool->processDelayed();
+                if (pool->hasWaiters() && pool->m_delayedCount.load(std::memory_order_relaxed) != 0)
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->armed = true;
+                }
+            }
+        }
+
+        // 把等待者移出等待队列，调用方需持有 m_waitMutex
+        void removeWaiter(Waiter& waiter)
+        {
+            (waiter.prev ? waiter.prev->next : m_waitHead) = waiter.next;
+            (waiter.next ? waiter.next->prev : m_waitTail) = waiter.prev;
+            waiter.prev = waiter.next = nullptr;
+            waiter.queued = false;
+            m_waiterCount.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        // 把对象交给队首的等待者，调用方需持有 m_waitMutex，并且添加分区后已经为等待者借到一个共享名额
+        // 同步等待者在持锁时通知，它被唤醒后才能返回并销毁栈上的节点；
+        // 异步等待者串入 resumeList，由调用方解锁后通过 resumeWaiters() 恢复
+        void assignHeadWaiter(T* object, Waiter*& resumeList)
+        {
+            // 等待者不指定分区，借到的共享名额记录在槽内，由 takeHandedOff() 保留、giveBack() 或释放时归还
+            slotOf(object)->partition = m_partitions.empty() ? kUncharged : kSharedPartition;
+            Waiter* waiter = m_waitHead;
+            removeWaiter(*waiter);
+            waiter->object = object;
+            waiter->ready = true;
+            if (waiter->resume)
+            {
+                waiter->next = resumeList;
+                resumeList = waiter;
+            }
+            else
+            {
+                static_cast<SyncWaiter*>(waiter)->cv.notify_one();
+            }
+        }
+
+        // 恢复已经收到对象的异步等待者，恢复后节点可能被销毁，需先取出下一个节点
+        static void resumeWaiters(Waiter* resumeList)
+        {
+            while (resumeList)
+            {
+                Waiter* next = resumeList->next;
+                resumeList->resume(*resumeList);
+                resumeList = next;
+            }
+        }
+
+        // 把用户释放的对象交给队首的等待者，没有等待者或共享名额已用完时返回 false
+        bool wakeWaiter(T* object, const void* callSite)
+        {
+            Waiter* resumeList = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(m_waitMutex);
+                if (!m_waitHead || borrowSharedUpTo(1) == 0)
+                {
+                    return false;
+                }
+                trace(TraceEvent::Release, object, callSite);
+                assignHeadWaiter(object, resumeList);
+            }
+            resumeWaiters(resumeList);
+            return true;
+        }
+
+        // 把 batch 开头的对象依次交给等待者，返回交出的数量，添加分区后以借到的共享名额为限
+        // outstanding 为 false 的对象交出前先计入 m_outstanding，避免等待者归还时计数下溢
+        // traceRelease 的含义同 releaseBatch()
+        size_t handOffBatch(const std::vector<T*>& batch, bool outstanding, bool traceRelease, const void* callSite)
+        {
+            Waiter* resumeList = nullptr;
+            size_t n = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_waitMutex);
+                n = borrowSharedUpTo(std::min(batch.size(), m_waiterCount.load(std::memory_order_relaxed)));
+                if (n == 0)
+                {
+                    return 0;
+                }
+                if (!outstanding)
+                {
+                    addOutstanding(n);
+                }
+                for (size_t i = 0; i < n; ++i)
+                {
+                    if (traceRelease)
+                    {
+                        trace(TraceEvent::Release, batch[i], callSite);
+                    }
+                    assignHeadWaiter(batch[i], resumeList);
+                }
+            }
+            resumeWaiters(resumeList);
+            return n;
+        }
+
+        // 从全局空闲列表(或在最大大小范围内新建)为等待者取对象
+        // 用于对象放回空闲列表或被销毁之后，覆盖释放方放回对象时还没有看到等待者的情况
+        // 每轮在锁内为一个尚未有人照应的等待者预留共享名额，在锁外取出或构造对象，再加锁交给队首的等待者；
+        // 等待者仍留在队列中，超时或被销毁时照常出队，取对象失败或等待者已经离开时归还名额与对象
+        void serveWaiters()
+        {
+            std::unique_lock<std::mutex> lock(m_waitMutex);
+            while (m_waiterCount.load(std::memory_order_relaxed) > m_servingCount && borrowSharedUpTo(1) == 1)
+            {
+                ++m_servingCount;
+                lock.unlock();
+                T* ptr = nullptr;
+                try
+                {
+                    ptr = acquireFromPool();
+                }
+                catch (...)
+                {
+                    // 创建对象失败时留给等待者自己重试
+                }
+                if (ptr)
+                {
+                    addOutstanding(1);
+                }
+                lock.lock();
+                --m_servingCount;
+                if (!ptr || !m_waitHead)
+                {
+                    returnShared(1);
+                    lock.unlock();
+                    if (ptr)
+                    {
+                        // 对象池可能在这里随计数归零而析构，此后不再访问成员
+                        std::vector<T*> batch(1, ptr);
+                        std::shared_ptr<BasicObjectPool> keepAlive = releaseBatch(batch);
+                    }
+                    return;
+                }
+                Waiter* resumeList = nullptr;
+                assignHeadWaiter(ptr, resumeList);
+                lock.unlock();
+                resumeWaiters(resumeList);
+                lock.lock();
+            }
+        }
+
+        // 接收释放方直接交来的对象，对象一直计入 m_outstanding，交出时借到的共享名额保留在槽内
+        std::unique_ptr<T, CustomDeleter> takeHandedOff(T* ptr, const void* callSite)
+        {
+            uint32_t partition = slotOf(ptr)->partition;
+            markAcquired(ptr);
+            slotOf(ptr)->partition = partition;
+            preProcess(ptr);
+            countStat(&StatShard::acquires);
+            trace(TraceEvent::AcquireHit, ptr, callSite);
+            return std::unique_ptr<T, CustomDeleter>(ptr);
+        }
+
+        // 归还等待者多拿到的一个对象及其交出时借到的共享名额，对象已执行过后处理
+        void giveBack(T* ptr)
+        {
+            if (slotOf(ptr)->partition != kUncharged)
+            {
+                unchargePartition(slotOf(ptr)->partition);
+                slotOf(ptr)->partition = kUncharged;
+            }
+            std::vector<T*> batch(1, ptr);
+            std::shared_ptr<BasicObjectPool> keepAlive = releaseBatch(batch);
+        }
+
+        // 等待直到获取到对象，deadline 为空表示不限时，超时返回空指针
+        // 入队后重新尝试一次，覆盖释放方放回对象时还没有看到等待者的情况(见 hasWaiters())；
+        // 此后只在收到对象、超时或有对象在延迟回收时间轮中时醒来；callSite 为追踪事件中的调用点
+        std::unique_ptr<T, CustomDeleter> waitForObject(const std::chrono::steady_clock::time_point* deadline, const void* callSite)
+        {
+            auto tryAcquire = [&] {
+                return acquireImpl([this] { return createObject(); }, [](T*) {}, kSharedPartition, callSite);
+            };
+            if (auto ptr = tryAcquire())
+            {
+                return ptr;
+            }
+            SyncWaiter waiter;
+            std::unique_lock<std::mutex> lock(m_waitMutex);
+            enqueueWaiter(waiter);
+            for (;;)
+            {
+                lock.unlock();
+                auto ptr = tryAcquire();
+                lock.lock();
+                if (waiter.ready)
+                {
+                    // 重新尝试期间收到了对象，多出的对象还回去
+                    T* object = waiter.object;
+                    lock.unlock();
+                    if (ptr)
+                    {
+                        giveBack(object);
+                        return ptr;
+                    }
+                    return takeHandedOff(object, callSite);
+                }
+                if (ptr)
+                {
+                    removeWaiter(waiter);
+                    return ptr;
+                }
+                if (deadline && std::chrono::steady_clock::now() >= *deadline)
+                {
+                    removeWaiter(waiter);
+                    return nullptr;
+                }
+
+                // 等待被唤醒；有延迟回收的对象时按时间轮的刻度轮询，使其到期后尽快被取走
+                // 被 pollWaiters() 或虚假唤醒时回到循环开头重新尝试
+                if (m_delayedCount.load(std::memory_order_relaxed) != 0)
+                {
+                    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(1);
+                    waiter.cv.wait_until(lock, deadline && *deadline < until ? *deadline : until);
+                }
+                else if (deadline)
+                {
+                    waiter.cv.wait_until(lock, *deadline);
+                }
+                else
+                {
+                    waiter.cv.wait(lock);
+                }
+                if (waiter.ready)
+                {
+                    T* object = waiter.object;
+                    lock.unlock();
+                    return takeHandedOff(object, callSite);
+                }
+            }
+        }
+
+        // 更新当前窗口的最低水位，窗口到期时由一个线程负责回收
+        void adaptTrim()
+        {
+            if (!m_trimEnabled)
+            {
+                return;
+            }
+            size_t available = m_availableCount.load(std::memory_order_relaxed);
+            size_t low = m_trimLowWater.load(std::memory_order_relaxed);
+            while (available < low &&
+                !m_trimLowWater.compare_exchange_weak(low, available, std::memory_order_relaxed))
+            {
+            }
+            if (m_trimWindow == 0)
+            {
+                return;
+            }
+            uint64_t now = delayTick();
+            uint64_t start = m_trimWindowStart.load(std::memory_order_relaxed);
+            // 只有成功推进窗口起点的线程执行回收
+            if (now - start < m_trimWindow ||
+                !m_trimWindowStart.compare_exchange_strong(start, now, std::memory_order_relaxed))
+            {
+                return;
+            }
+            endTrimWindow();
+        }
+
+        // 销毁最低水位高出 minIdle 的空闲对象，并以回收后的空闲数量开始新窗口
+        size_t endTrimWindow()
+        {
+            size_t low = std::min(m_trimLowWater.load(std::memory_order_relaxed),
+                m_availableCount.load(std::memory_order_relaxed));
+            size_t n = low > m_trimMinIdle ? destroyIdle(low - m_trimMinIdle) : 0;
+            m_trimLowWater.store(m_availableCount.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return n;
+        }
+
+        // 从全局空闲列表取出最多 count 个对象并在锁外销毁，返回销毁的数量
+        // 互斥锁模式下取最早放入(最久未被使用)的对象
+        size_t destroyIdle(size_t count)
+        {
+            std::vector<T*> objects = takeBatchBuffer();
+            if constexpr (Policy::lockFree)
+            {
+                while (objects.size() < count)
+                {
+                    Slot* slot = popFreeSlot();
+                    if (!slot) break;
+                    objects.push_back(slot->object());
+                }
+            }
+            else
+            {
+                std::unique_lock<Mutex> lock = lockPool();
+                size_t n = std::min(count, m_pool.size());
+                objects.insert(objects.end(), m_pool.begin(), m_pool.begin() + n);
+                m_pool.erase(m_pool.begin(), m_pool.begin() + n);
+                m_availableCount.store(m_pool.size(), std::memory_order_relaxed);
+            }
+            for (T* ptr : objects)
+            {
+                // 调用最终处理函数并销毁对象
+                destroyObject(ptr);
+            }
+            size_t n = objects.size();
+            countStat(&StatShard::trimmed, n);
+            returnBatchBuffer(std::move(objects));
+            return n;
+        }
+
+        // 当前线程使用的计数器分片
+        StatShard& statShard()
+        {
+            static thread_local const size_t index = [] {
+                static std::atomic<size_t> next{ 0 };
+                return next.fetch_add(1, std::memory_order_relaxed);
+            }();
+            return m_statShards[index % kStatShards];
+        }
+
+        // 累加一个统计计数器
+        void countStat(std::atomic<uint64_t> StatShard::* counter, uint64_t n = 1)
+        {
+            if constexpr (Policy::collectStats)
+            {
+                if (n > 0)
+                {
+                    (statShard().*counter).fetch_add(n, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // 记录一次 acquire 的耗时
+        void recordAcquireLatency(std::chrono::steady_clock::time_point begin)
+        {
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+            size_t bucket = 0;
+            for (uint64_t v = static_cast<uint64_t>(ns); v > 1 && bucket + 1 < kLatencyBuckets; v >>= 1)
+            {
+                ++bucket;
+            }
+            statShard().acquireLatency[bucket].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // 加锁 m_mutex，锁已被其它线程持有时计入 contendedLocks
+        std::unique_lock<Mutex> lockPool()
+        {
+            if constexpr (Policy::collectStats)
+            {
+                std::unique_lock<Mutex> lock(m_mutex, std::try_to_lock);
+                if (!lock.owns_lock())
+                {
+                    countStat(&StatShard::contendedLocks);
+                    lock.lock();
+                }
+                return lock;
+            }
+            else
+            {
+                return std::unique_lock<Mutex>(m_mutex);
+            }
+        }
+
+        // 时间轮的当前刻度
+        uint64_t delayTick() const
+        {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - m_delayEpoch).count());
+        }
+
+        // 取出当前线程复用的批量操作缓冲区，避免每次批量操作都分配内存
+        // 缓冲区以移动的方式取出，回调函数中再次调用批量接口时会得到新的缓冲区
+        static std::vector<T*> takeBatchBuffer()
+        {
+            std::vector<T*> buffer = std::move(batchBuffer());
+            buffer.clear();
+            return buffer;
+        }
+
+        // 归还批量操作缓冲区
+        static void returnBatchBuffer(std::vector<T*>&& buffer)
+        {
+            batchBuffer() = std::move(buffer);
+        }
+
+        // 当前线程的批量操作缓冲区
+        static std::vector<T*>& batchBuffer()
+        {
+            static thread_local std::vector<T*> buffer;
+            return buffer;
+        }
+
+        // 增加已被获取的对象数量，cache 为当前线程的本地缓存时计在缓存中，不修改共享的计数
+        void addOutstanding(size_t n, ThreadCache* cache = nullptr)
+        {
+            if (n == 0)
+            {
+                return;
+            }
+            if (cache)
+            {
+                // 计数只会增加，不会使对象池析构
+                countInCache(*cache, n);
+                return;
+            }
+            size_t previous = m_outstanding.fetch_add(n, std::memory_order_relaxed);
+            // 未开启线程本地缓存时共享的计数就是全部，顺便采样峰值，峰值很少被改写，大多数情况下只有一次读取
+            if (m_threadCacheSize == 0 && previous >= kAttached)
+            {
+                samplePeak(previous - kAttached + n);
+            }
+        }
+
+        // 减少已被获取的对象数量，返回值非空时对象池已被用户放弃且这是最后一个对象，
+        // 调用方在不再访问对象池后释放它，此时对象池析构
+        std::shared_ptr<BasicObjectPool> removeOutstanding(size_t n, ThreadCache* cache = nullptr)
+        {
+            if (n == 0)
+            {
+                return nullptr;
+            }
+            if (cache)
+            {
+                return countInCache(*cache, size_t{ 0 } - n);
+            }
+            if (m_outstanding.fetch_sub(n, std::memory_order_acq_rel) == n)
+            {
+                return adoptSelf();
+            }
+            return nullptr;
+        }
+
+        // 修改当前线程本地缓存中的计数，只写所属线程自己的缓存行，没有共享的读-改-写
+        // 与 detach() 配对：m_detached 之前的修改由 detach() 并入 m_outstanding，之后的修改由本线程自己并入
+        std::shared_ptr<BasicObjectPool> countInCache(ThreadCache& cache, size_t delta)
+        {
+            cache.outstanding.fetch_add(delta, std::memory_order_seq_cst);
+            if (!m_detached.load(std::memory_order_seq_cst))
+            {
+                return nullptr;
+            }
+            size_t residue = cache.outstanding.exchange(0, std::memory_order_seq_cst);
+            if (residue != 0 && m_outstanding.fetch_add(residue, std::memory_order_acq_rel) + residue == 0)
+            {
+                return adoptSelf();
+            }
+            return nullptr;
+        }
+
+        // create() 返回的 std::shared_ptr 的删除器：用户释放对象池的最后一个强引用时调用
+        struct Retire
+        {
+            void operator()(BasicObjectPool* pool) const
+            {
+                std::shared_ptr<BasicObjectPool> last = pool->detach();
+            }
+        };
+
+        // 对象池的生命周期：用户放弃对象池时把各线程本地缓存中的计数并入 m_outstanding 并去掉 kAttached，
+        // 没有对象在外时立即析构；否则对象池继续存活，使计数归零的最后一次归还析构对象池，
+        // 删除器通过槽内回指访问对象池时对象池总是存活的。线程本地缓存中的空闲对象不计入，不会延长对象池的生命周期
+        // 此后用户的 std::weak_ptr 已经失效，后台线程与线程退出时的清理不再访问对象池
+        // 只有通过 create() 创建的对象池会这样延迟析构，其它方式创建的对象池必须比其对象存活得更久
+        std::shared_ptr<BasicObjectPool> detach()
+        {
+            m_detached.store(true, std::memory_order_seq_cst);
+            {
+                std::lock_guard<Mutex> lock(m_mutex);
+                for (auto& cache : m_threadCaches)
+                {
+                    m_outstanding.fetch_add(cache->outstanding.exchange(0, std::memory_order_seq_cst), std::memory_order_relaxed);
+                }
+            }
+            if (m_outstanding.fetch_sub(kAttached, std::memory_order_acq_rel) == kAttached)
+            {
+                return adoptSelf();
+            }
+            return nullptr;
+        }
+
+        // 接管已被用户放弃的对象池，返回的强引用释放时析构对象池
+        std::shared_ptr<BasicObjectPool> adoptSelf()
+        {
+            return std::shared_ptr<BasicObjectPool>(this);
+        }
+
+        // 已被获取、尚未归还的对象数量：m_outstanding 与各线程本地缓存中的计数之和
+        size_t outstandingCount() const
+        {
+            size_t count = m_outstanding.load(std::memory_order_relaxed);
+            if (!m_detached.load(std::memory_order_relaxed))
+            {
+                count -= kAttached;
+            }
+            {
+                std::lock_guard<Mutex> lock(m_mutex);
+                for (const auto& cache : m_threadCaches)
+                {
+                    count += cache->outstanding.load(std::memory_order_relaxed);
+                }
+            }
+            // 各计数分别读取，与获取和释放并发时和可能暂时为"负"
+            return static_cast<std::ptrdiff_t>(count) < 0 ? 0 : count;
+        }
+
+        // 采样历史峰值：在 stats()、新建对象、补充线程本地缓存与未开启线程本地缓存时的获取中进行，
+        // 不在每次获取时读写共享的计数
+        void samplePeak(size_t outstanding) const
+        {
+            if constexpr (Policy::collectStats)
+            {
+                size_t peak = m_peakOutstanding.load(std::memory_order_relaxed);
+                while (outstanding > peak &&
+                    !m_peakOutstanding.compare_exchange_weak(peak, outstanding, std::memory_order_relaxed))
+                {
+                }
+            }
+        }
+
+        // 同上，读取当前的已获取数量
+        void samplePeak() const
+        {
+            if constexpr (Policy::collectStats)
+            {
+                samplePeak(outstandingCount());
+            }
+        }
+
+        // 从无锁空闲列表中弹出一个槽
+        Slot* popFreeSlot()
+        {
+            Slot* slot = m_freeList.pop();
+            if (slot)
+            {
+                m_availableCount.fetch_sub(1, std::memory_order_relaxed);
+            }
+            return slot;
+        }
+
+        // 在最大大小(以及共享的对象数量上限)范围内预留一个新对象的名额
+        bool reserveObject()
+        {
+            size_t count = m_acquiredCount.load(std::memory_order_relaxed);
+            do
+            {
+                if (count >= m_maxSize)
+                {
+                    return false;
+                }
+            } while (!m_acquiredCount.compare_exchange_weak(count, count + 1, std::memory_order_relaxed));
+            if (m_budget && !m_budget->tryReserve())
+            {
+                --m_acquiredCount;
+                return false;
+            }
+            return true;
+        }
+
+        // 归还 reserveObject() 预留的名额
+        void unreserveObject()
+        {
+            --m_acquiredCount;
+            if (m_budget)
+            {
+                m_budget->used.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        // 从全局空闲列表获取对象，空闲列表为空时在最大大小范围内创建新对象
+        T* acquireFromPool()
+        {
+            return acquireFromPool([this] { return createObject(); });
+        }
+
+        // 同上，新对象由 make 创建
+        template <typename Make>
+        T* acquireFromPool(Make&& make)
+        {
+            if constexpr (Policy::lockFree)
+            {
+                if (Slot* slot = popFreeSlot())
+                {
+                    return slot->object();
+                }
+                // 如果空闲列表为空且已分配的对象数量小于最大大小，创建一个新对象
+                if (!reserveObject())
+                {
+                    return nullptr;
+                }
+                try
+                {
+                    T* ptr = make();
+                    countStat(&StatShard::creates);
+                    return ptr;
+                }
+                catch (...)
+                {
+                    // 创建失败时归还预留的名额
+                    unreserveObject();
+                    throw;
+                }
+            }
+            else
+            {
+                T* ptr = nullptr;
+                // 加锁，保证线程安全
+                std::unique_lock<Mutex> lock = lockPool();
+                // 如果对象池不为空
+                if (!m_pool.empty())
+                {
+                    // 从对象池的末尾取出一个对象
+                    ptr = m_pool.back();
+                    m_pool.pop_back();
+                    m_availableCount.store(m_pool.size(), std::memory_order_relaxed);
+                }
+                // 如果对象池为空且已分配的对象数量小于最大大小
+                else if (reserveObject())
+                {
+                    // 名额已经预留，在锁外创建新对象，构造期间不阻塞其它线程
+                    lock.unlock();
+                    try
+                    {
+                        ptr = make();
+                    }
+                    catch (...)
+                    {
+                        unreserveObject();
+                        throw;
+                    }
+                    countStat(&StatShard::creates);
+                }
+                return ptr;
+            }
+        }
+
+        // acquire_n 创建对象失败时撤销失败对象预留的名额与借用的 charged 个共享名额，
+        // 并把批次中已经取出或创建的对象放回对象池
+        // 前 reused 个对象来自空闲列表，仍带有空闲标记；返回值见 removeOutstanding()
+        std::shared_ptr<BasicObjectPool> abandonBatch(const std::vector<T*>& batch, size_t reused, size_t charged)
+        {
+            unreserveObject();
+            returnShared(charged);
+            if constexpr (Policy::checkDoubleRelease)
+            {
+                for (size_t i = reused; i < batch.size(); ++i)
+                {
+                    slotOf(batch[i])->idle.store(true, std::memory_order_relaxed);
+                }
+            }
+            addOutstanding(batch.size());
+            return releaseBatch(batch);
+        }
+
+        // 将对象标记为已获取，owner 为获取它的线程的本地缓存
+        static void markAcquired(T* ptr, ThreadCache* owner = nullptr)
+        {
+            slotOf(ptr)->owner = owner;
+            slotOf(ptr)->partition = kUncharged;
+            if constexpr (Policy::checkDoubleRelease)
+            {
+                slotOf(ptr)->idle.store(false, std::memory_order_relaxed);
+            }
+            updateOccupancy(ptr, kOutstandingBitmap, true);
+        }
+
+        // 将对象标记为空闲并归还它计入的分区配额，对象已经是空闲状态(重复释放)时返回 false
+        bool markReleased(T* ptr)
+        {
+            if constexpr (Policy::checkDoubleRelease)
+            {
+                if (slotOf(ptr)->idle.exchange(true, std::memory_order_relaxed))
+                {
+                    return false;
+                }
+            }
+            updateOccupancy(ptr, kOutstandingBitmap, false);
+            if (slotOf(ptr)->partition != kUncharged)
+            {
+                unchargePartition(slotOf(ptr)->partition);
+                slotOf(ptr)->partition = kUncharged;
+            }
+            return true;
+        }
+
+        // 按分区配额计入一个对象，超出配额时返回 false
+        // 分区持有的对象少于 reserved 时直接计入，否则先从共享名额中借用一个
+        bool chargePartition(uint32_t partition)
+        {
+            if (partition == kSharedPartition)
+            {
+                return borrowShared();
+            }
+            Partition& p = *m_partitions[partition];
+            size_t used = p.used.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                bool borrow = used >= p.reserved;
+                if (used >= p.limit || (borrow && !borrowShared()))
+                {
+                    p.failures.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+                if (p.used.compare_exchange_weak(used, used + 1, std::memory_order_relaxed))
+                {
+                    return true;
+                }
+                // 计数已被其它线程改变，是否需要借用要按新的计数重新判断
+                if (borrow)
+                {
+                    m_sharedUsed.fetch_sub(1, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // 归还 chargePartition() 计入的一个对象，超出 reserved 的部分同时归还共享名额
+        void unchargePartition(uint32_t partition)
+        {
+            if (partition == kSharedPartition)
+            {
+                m_sharedUsed.fetch_sub(1, std::memory_order_relaxed);
+                return;
+            }
+            Partition& p = *m_partitions[partition];
+            if (p.used.fetch_sub(1, std::memory_order_relaxed) > p.reserved)
+            {
+                m_sharedUsed.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+
+        // 从共享名额中借用一个
+        bool borrowShared()
+        {
+            size_t used = m_sharedUsed.load(std::memory_order_relaxed);
+            do
+            {
+                if (used >= m_sharedCapacity)
+                {
+                    return false;
+                }
+            } while (!m_sharedUsed.compare_exchange_weak(used, used + 1, std::memory_order_relaxed));
+            return true;
+        }
+
+        // 为不指定分区的 n 个对象借用共享名额，返回借到的数量；没有分区时不计费，直接返回 n
+        size_t borrowSharedUpTo(size_t n)
+        {
+            if (m_partitions.empty())
+            {
+                return n;
+            }
+            size_t borrowed = 0;
+            while (borrowed < n && borrowShared())
+            {
+                ++borrowed;
+            }
+            return borrowed;
+        }
+
+        // 归还 borrowSharedUpTo() 借到但没有用上的 n 个共享名额
+        void returnShared(size_t n)
+        {
+            if (!m_partitions.empty() && n > 0)
+            {
+                m_sharedUsed.fetch_sub(n, std::memory_order_relaxed);
+            }
+        }
+
+        // 在占用位图中设置或清除对象所在槽的一位，未开启占用位图时什么也不做
+        static void updateOccupancy(T* ptr, size_t which, bool set)
+        {
+            if constexpr (Policy::occupancyBitmap)
+            {
+                Slot* slot = slotOf(ptr);
+                size_t index = static_cast<size_t>(slot - slot->chunk->slots());
+                std::atomic<uint64_t>& word = slot->chunk->bitmap(which)[index / 64];
+                uint64_t bit = uint64_t(1) << (index % 64);
+                if (set)
+                {
+                    // 与扫描时的 acquire 读配对，扫描到置位时对象已经构造完成
+                    word.fetch_or(bit, std::memory_order_release);
+                }
+                else
+                {
+                    word.fetch_and(~bit, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // 对象析构前清除 live 位，持有 slab 锁清除，正在进行的扫描结束后才能继续析构
+        void clearLive(T* ptr)
+        {
+            if constexpr (Policy::occupancyBitmap)
+            {
+                std::lock_guard<std::mutex> lock(m_slabMutex);
+                updateOccupancy(ptr, kLiveBitmap, false);
+            }
+        }
+
+        // for_each_outstanding()/for_each_idle() 的实现，按块逐字扫描 live 与 outstanding 位图
+        template <typename Func>
+        size_t forEachOccupied(Func& fn, bool outstanding)
+        {
+            static_assert(Policy::occupancyBitmap, "for_each_outstanding()/for_each_idle() require Policy::occupancyBitmap, e.g. SlabBitmapPoolPolicy");
+            size_t visited = 0;
+            std::lock_guard<std::mutex> lock(m_slabMutex);
+            for (Chunk* chunk : m_chunks)
+            {
+                Slot* slots = chunk->slots();
+                std::atomic<uint64_t>* live = chunk->bitmap(kLiveBitmap);
+                std::atomic<uint64_t>* taken = chunk->bitmap(kOutstandingBitmap);
+                for (size_t w = 0; w < chunk->bitmapWords(); ++w)
+                {
+                    uint64_t bits = live[w].load(std::memory_order_acquire);
+                    uint64_t out = taken[w].load(std::memory_order_relaxed);
+                    bits &= outstanding ? out : ~out;
+                    while (bits)
+                    {
+                        Slot* slot = slots + w * 64 + countTrailingZeros(bits);
+                        bits &= bits - 1;
+                        // 访问当前对象时预取同一个字中的下一个对象
+                        if (bits)
+                        {
+                            prefetch(slots + w * 64 + countTrailingZeros(bits));
+                        }
+                        fn(*slot->object());
+                        ++visited;
+                    }
+                }
+            }
+            return visited;
+        }
+
+        // 由对象指针得到所在的槽
+        static Slot* slotOf(T* ptr)
+        {
+            return reinterpret_cast<Slot*>(reinterpret_cast<unsigned char*>(ptr));
+        }
+
+        // 分配一个尚未构造对象的槽
+        Slot* allocateSlot()
+        {
+            if constexpr (Policy::slabChunkSize == 0)
+            {
+                if constexpr (Policy::lockFree)
+                {
+                    // 无锁模式下优先复用之前保留下来的槽
+                    std::lock_guard<std::mutex> lock(m_slabMutex);
+                    if (Slot* slot = m_rawSlots)
+                    {
+                        m_rawSlots = slot->next.load(std::memory_order_relaxed);
+                        return slot;
+                    }
+                }
+                return new (m_resource->allocate(sizeof(Slot), alignof(Slot))) Slot;
+            }
+            else
+            {
+                std::lock_guard<std::mutex> lock(m_slabMutex);
+                // 没有未使用的槽时，分配一个新的 slab 块
+                if (!m_rawSlots)
+                {
+                    addChunk(Policy::slabChunkSize);
+                }
+                Slot* slot = m_rawSlots;
+                m_rawSlots = slot->next.load(std::memory_order_relaxed);
+                return slot;
+            }
+        }
+
+        // 归还一个已析构对象的槽，slab 块中的槽留给之后创建的对象复用；
+        // 无锁模式下其他线程的 pop 可能仍在读取刚弹出槽的 next，单独分配的槽同样保留到对象池析构时才释放
+        void deallocateSlot(Slot* slot)
+        {
+            if (!Policy::lockFree && !slot->chunk)
+            {
+                slot->~Slot();
+                m_resource->deallocate(slot, sizeof(Slot), alignof(Slot));
+                return;
+            }
+            std::lock_guard<std::mutex> lock(m_slabMutex);
+            slot->next.store(m_rawSlots, std::memory_order_relaxed);
+            m_rawSlots = slot;
+        }
+
+        // 在最大大小范围内创建 count 个对象并放入空闲列表，返回实际创建的数量，需要的槽由调用方预先分配
+        size_t createIdle(size_t count)
+        {
+            std::vector<T*> batch = takeBatchBuffer();
+            try
+            {
+                while (batch.size() < count)
+                {
+                    // 预留一个新对象的名额
+                    if (!reserveObject()) break;
+                    T* obj = nullptr;
+                    try
+                    {
+                        obj = createObject();
+                    }
+                    catch (...)
+                    {
+                        // 创建失败时归还预留的名额
+                        unreserveObject();
+                        throw;
+                    }
+                    markReleased(obj);
+                    batch.push_back(obj);
+                }
+            }
+            catch (...)
+            {
+                // 已经创建的对象照常放回空闲列表
+                releaseBatch(batch, false);
+                returnBatchBuffer(std::move(batch));
+                throw;
+            }
+            releaseBatch(batch, false);
+            size_t n = batch.size();
+            returnBatchBuffer(std::move(batch));
+            return n;
+        }
+
+        // 全局空闲列表低于低水位时唤醒后台补充线程，已经唤醒过且补充尚未结束时不再重复唤醒
+        void checkWatermark()
+        {
+            if (m_refillLow == 0 || !m_refill || m_availableCount.load(std::memory_order_relaxed) >= m_refillLow)
+            {
+                return;
+            }
+            if (m_refillPending.load(std::memory_order_relaxed) || m_refillPending.exchange(true, std::memory_order_relaxed))
+            {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(m_refill->mutex);
+            m_refill->requested = true;
+            m_refill->cv.notify_one();
+        }
+
+        // 后台补充线程，每次被唤醒时临时持有对象池的强引用并调用 maintain()
+        static void refillWorker(std::weak_ptr<BasicObjectPool> weak, std::shared_ptr<RefillState> state)
+        {
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(state->mutex);
+                    state->cv.wait(lock, [&] { return state->requested || state->stopped; });
+                    if (state->stopped)
+                    {
+                        return;
+                    }
+                    state->requested = false;
+                }
+                // 只剩补充线程持有强引用(用户已经放弃对象池)时不再补充，强引用在这里释放时可能析构对象池
+                std::shared_ptr<BasicObjectPool> pool = weak.lock();
+                if (!pool)
+                {
+                    return;
+                }
+                if (pool.use_count() > 1)
+                {
+                    try
+                    {
+                        pool->maintain();
+                    }
+                    catch (...)
+                    {
+                        // 创建失败时等待下一次唤醒再试，由 acquire 自己创建对象
+                    }
+                }
+                pool->m_refillPending.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        // 一次 prewarm() 的共享状态，由调用方与所有补充线程共同持有
+        struct WarmState
+        {
+            // 尚未被补充线程认领的对象数量
+            std::atomic<size_t> pending{ 0 };
+            // 仍在运行的补充线程数量
+            std::atomic<size_t> running{ 0 };
+            // 已经新建的对象数量
+            std::atomic<size_t> created{ 0 };
+            // 正持有对象池强引用的补充线程数量
+            std::atomic<size_t> holders{ 0 };
+            // 第一个创建失败的异常
+            std::mutex errorMutex;
+            std::exception_ptr error;
+            // 最后一个补充线程结束时设置
+            std::promise<size_t> done;
+        };
+
+        // 补充线程每次认领并创建的对象数量
+        static constexpr size_t kWarmBatch = 16;
+
+        // prewarm() 的补充线程，每创建一批对象才临时持有一次对象池的强引用
+        static void warmWorker(std::weak_ptr<BasicObjectPool> weak, std::shared_ptr<WarmState> state)
+        {
+            try
+            {
+                for (;;)
+                {
+                    // 认领一批尚未创建的对象
+                    size_t pending = state->pending.load(std::memory_order_relaxed);
+                    size_t n = 0;
+                    do
+                    {
+                        n = std::min(pending, kWarmBatch);
+                    } while (n != 0 && !state->pending.compare_exchange_weak(pending, pending - n, std::memory_order_relaxed));
+                    if (n == 0) break;
+                    // 对象池已经析构，或者只剩补充线程持有强引用(用户已经放弃对象池)时结束补充；
+                    // 强引用在本轮结束时释放，可能在这里析构对象池，此后不再访问对象池
+                    std::shared_ptr<BasicObjectPool> pool = weak.lock();
+                    if (!pool) break;
+                    size_t holders = state->holders.fetch_add(1, std::memory_order_relaxed) + 1;
+                    size_t created = 0;
+                    if (static_cast<size_t>(pool.use_count()) > holders)
+                    {
+                        created = pool->createIdle(n);
+                    }
+                    state->holders.fetch_sub(1, std::memory_order_relaxed);
+                    state->created.fetch_add(created, std::memory_order_relaxed);
+                    // 达到最大大小或已被放弃
+                    if (created < n) break;
+                }
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(state->errorMutex);
+                if (!state->error)
+                {
+                    state->error = std::current_exception();
+                }
+                // 通知其它补充线程停止认领
+                state->pending.store(0, std::memory_order_relaxed);
+            }
+            finishWarmWorker(*state);
+        }
+
+        // 一个补充线程结束，最后一个结束的线程给出 prewarm() 的结果
+        static void finishWarmWorker(WarmState& state)
+        {
+            if (state.running.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            {
+                return;
+            }
+            if (state.error)
+            {
+                state.done.set_exception(state.error);
+            }
+            else
+            {
+                state.done.set_value(state.created.load(std::memory_order_relaxed));
+            }
+        }
+
+        // 预先分配至少容纳 count 个对象的 slab 块，使初始对象位于同一块连续内存中
+        void reserveSlots(size_t count)
+        {
+            if constexpr (Policy::slabChunkSize != 0)
+            {
+                if (count == 0) return;
+                std::lock_guard<std::mutex> lock(m_slabMutex);
+                addChunk(std::max(count, Policy::slabChunkSize));
+            }
+        }
+
+        // 分配一个包含 capacity 个槽的 slab 块，并把其中的槽加入未使用列表
+        void addChunk(size_t capacity)
+        {
+            size_t size = chunkBytes(capacity);
+            void* memory = m_resource->allocate(size, kChunkAlignment);
+            // 在构造槽(首次访问)之前绑定 NUMA 节点
+            if (m_numaNode >= 0)
+            {
+                bindToNumaNode(memory, size, static_cast<size_t>(m_numaNode));
+            }
+            Chunk* chunk = new (memory) Chunk;
+            chunk->capacity = capacity;
+            if constexpr (Policy::occupancyBitmap)
+            {
+                std::atomic<uint64_t>* words = chunk->bitmap(kLiveBitmap);
+                for (size_t i = 0; i < 2 * chunk->bitmapWords(); ++i)
+                {
+                    new (words + i) std::atomic<uint64_t>(0);
+                }
+            }
+            Slot* slots = chunk->slots();
+            // 逆序加入未使用列表，使对象按内存顺序被创建
+            for (size_t i = capacity; i > 0; --i)
+            {
+                Slot* slot = new (slots + i - 1) Slot;
+                slot->chunk = chunk;
+                slot->next.store(m_rawSlots, std::memory_order_relaxed);
+                m_rawSlots = slot;
+            }
+            m_chunks.push_back(chunk);
+        }
+
+        // 包含 capacity 个槽的 slab 块(以及占用位图)所占的字节数
+        static size_t chunkBytes(size_t capacity)
+        {
+            size_t bitmapBytes = Policy::occupancyBitmap ? 2 * ((capacity + 63) / 64) * sizeof(std::atomic<uint64_t>) : 0;
+            return kChunkHeaderSize + capacity * sizeof(Slot) + bitmapBytes;
+        }
+
+        // 归还所有 slab 块以及无锁模式下保留的槽的内存，调用前对象必须已全部销毁
+        void releaseChunks()
+        {
+            std::lock_guard<std::mutex> lock(m_slabMutex);
+            // 无锁模式下保留的单独分配的槽
+            for (Slot* slot = m_rawSlots; slot;)
+            {
+                Slot* next = slot->next.load(std::memory_order_relaxed);
+                if (!slot->chunk)
+                {
+                    slot->~Slot();
+                    m_resource->deallocate(slot, sizeof(Slot), alignof(Slot));
+                }
+                slot = next;
+            }
+            for (Chunk* chunk : m_chunks)
+            {
+                size_t size = chunkBytes(chunk->capacity);
+                chunk->~Chunk();
+                m_resource->deallocate(chunk, size, kChunkAlignment);
+            }
+            m_chunks.clear();
+            m_rawSlots = nullptr;
+        }
+
+        // 调用预处理函数：先调用编译期处理函数，再调用运行期设置的处理函数
+        void preProcess(T* ptr)
+        {
+            if constexpr (!std::is_same<typename Policy::PreProcessHook, NoHook>::value)
+            {
+                static_cast<HookHolder<typename Policy::PreProcessHook, 0>&>(*this).hook()(ptr);
+            }
+            if constexpr (Policy::runtimeHooks)
+            {
+                // 如果预处理函数不为空
+                if (m_preProcess)
+                {
+                    m_preProcess(ptr);
+                }
+            }
+        }
+
+        // 调用后处理函数
+        void postProcess(T* ptr)
+        {
+            // 先按重置协议原地重置对象
+            if constexpr (Policy::resetOnRelease && reset_traits<T>::enabled)
+            {
+                reset_traits<T>::reset(*ptr);
+            }
+            if constexpr (!std::is_same<typename Policy::PostProcessHook, NoHook>::value)
+            {
+                static_cast<HookHolder<typename Policy::PostProcessHook, 1>&>(*this).hook()(ptr);
+            }
+            if constexpr (Policy::runtimeHooks)
+            {
+                // 如果后处理函数不为空
+                if (m_postProcess)
+                {
+                    m_postProcess(ptr);
+                }
+            }
+        }
+
+        // 调用最终处理函数
+        void finalProcess(T* ptr)
+        {
+            if constexpr (!std::is_same<typename Policy::FinalProcessHook, NoHook>::value)
+            {
+                static_cast<HookHolder<typename Policy::FinalProcessHook, 2>&>(*this).hook()(ptr);
+            }
+            if constexpr (Policy::runtimeHooks)
+            {
+                // 如果最终处理函数不为空
+                if (m_finalProcess)
+                {
+                    m_finalProcess(ptr);
+                }
+            }
+        }
+
+        // 调用追踪策略，NoTracer 时整个调用在编译期被去掉
+        void trace(TraceEvent event, const void* object, const void* callSite)
+        {
+            if constexpr (!std::is_same<typename Policy::Tracer, NoTracer>::value)
+            {
+                static_cast<HookHolder<typename Policy::Tracer, 3>&>(*this).hook()(event, m_poolId, object, callSite);
+            }
+            else
+            {
+                (void)event;
+                (void)object;
+                (void)callSite;
+            }
+        }
+
+        // 按 Policy::traceCallSiteSampling 采样调用点，每个线程每 N 次采样一次，其余返回空指针
+        static const void* sampleCallSite(const void* callSite)
+        {
+            if constexpr (std::is_same<typename Policy::Tracer, NoTracer>::value || Policy::traceCallSiteSampling == 0)
+            {
+                (void)callSite;
+                return nullptr;
+            }
+            else
+            {
+                static thread_local size_t countdown = 0;
+                if (countdown-- == 0)
+                {
+                    countdown = Policy::traceCallSiteSampling - 1;
+                    return callSite;
+                }
+                return nullptr;
+            }
+        }
+
+        // 销毁一个对象，同时更新计数
+        void destroyObject(T* ptr)
+        {
+            clearLive(ptr);
+            // 调用最终处理函数
+            finalProcess(ptr);
+            ptr->~T();
+            discardSlot(ptr);
+        }
+
+        // 回收一个对象已经析构的槽，同时更新计数
+        void discardSlot(T* ptr)
+        {
+            --m_realAllocedCount;
+            unreserveObject();
+            deallocateSlot(slotOf(ptr));
+            // 空出了一个名额，为等待者新建对象
+            if (hasWaiters())
+            {
+                serveWaiters();
+            }
+        }
+
+        // 构造函数
+        BasicObjectPool(size_t initialSize,
+            size_t maxSize,
+            Args&&... args)
+            : BasicObjectPool(std::allocator_arg, std::pmr::get_default_resource(), initialSize, maxSize, std::forward<Args>(args)...)
+        {
+        }
+
+        // 构造函数，对象存储与簿记结构从 resource 分配
+        BasicObjectPool(std::allocator_arg_t,
+            std::pmr::memory_resource* resource,
+            size_t initialSize,
+            size_t maxSize,
+            Args&&... args)
+            : m_resource(resource),
+            m_maxSize(maxSize),
+            m_constructorArgs(std::forward<Args>(args)...)
+        {
+            try
+            {
+                // slab 模式下初始对象一次性分配在同一块内存中
+                reserveSlots(initialSize);
+                // 初始化对象池，创建指定数量的对象
+                for (size_t i = 0; i < initialSize; ++i)
+                {
+                    T* obj = createObject();
+                    ++m_acquiredCount;
+                    markReleased(obj);
+                    if constexpr (Policy::lockFree)
+                    {
+                        m_freeList.push(slotOf(obj));
+                        ++m_availableCount;
+                    }
+                    else
+                    {
+                        m_pool.emplace_back(obj);
+                        m_availableCount.store(m_pool.size(), std::memory_order_relaxed);
+                    }
+                }
+            }
+            catch (const std::bad_alloc& e)
+            {
+                // 处理内存分配失败的异常
+                std::cerr << "Memory allocation failed: " << e.what() << std::endl;
+                // 销毁已经创建的对象
+                clear();
+                releaseChunks();
+                throw;
+            }
+        }
+
+        // 创建对象的方法
+        T* createObject()
+        {
+            // 调用辅助函数创建对象
+            return createObjectHelper(make_index_sequence<sizeof...(Args)>{});
+        }
+
+        // 辅助函数，用于展开构造函数参数
+        template <size_t... Is>
+        T* createObjectHelper(index_sequence<Is...>)
+        {
+            // 使用元组中的参数构造对象
+            return emplaceObject(std::get<Is>(m_constructorArgs)...);
+        }
+
+        // 分配槽，并使用给定的参数在槽内构造对象
+        template <typename... CtorArgs>
+        T* emplaceObject(CtorArgs&&... args)
+        {
+            Slot* slot = allocateSlot();
+            slot->pool = this;
+            // 复用的 slab 槽可能残留上一个对象的空闲标记与分区
+            slot->idle.store(false, std::memory_order_relaxed);
+            slot->partition = kUncharged;
+            T* ptr = nullptr;
+            try
+            {
+                ptr = new (slot->storage) T(std::forward<CtorArgs>(args)...);
+            }
+            catch (...)
+            {
+                deallocateSlot(slot);
+                throw;
+            }
+            updateOccupancy(ptr, kLiveBitmap, true);
+            ++m_realAllocedCount;
+            return ptr;
+        }
+
+        // 释放对象的方法
+        void release(std::unique_ptr<T, CustomDeleter> ptr)
+        {
+            // 如果对象指针为空，直接返回
+            if (!ptr) return;
+
+            // 获取原始指针
+            T* rawPtr = ptr.release();
+            const void* callSite = sampleCallSite(CPPOBJECTPOOL_CALL_SITE());
+
+            // 对象池已被用户放弃时最后一个对象的归还析构对象池，需要在函数返回前保持对象池存活
+            std::shared_ptr<BasicObjectPool> keepAlive;
+
+            // 通过槽内的空闲标记检测重复释放，对象已经是空闲状态时直接返回
+            if (!markReleased(rawPtr)) return;
+            countStat(&StatShard::releases);
+
+            // 在锁外调用后处理函数
+            postProcess(rawPtr);
+
+            // 有线程在等待时直接把对象交给最早的等待者，对象仍计入 m_outstanding
+            // Release 事件只在对象回到对象池时发出，并且早于对象可以被再次获取，被销毁的对象只发出 Drop
+            if (m_waiterCount.load(std::memory_order_relaxed) != 0 && wakeWaiter(rawPtr, callSite))
+            {
+                return;
+            }
+
+            // 优先放回线程本地缓存
+            if (ThreadCache* cache = localThreadCache())
+            {
+                trace(TraceEvent::Release, rawPtr, callSite);
+                // 对象由其它线程获取时，用一次 CAS 压入该线程的远程释放列表，不与它竞争空闲列表
+                ThreadCache* owner = slotOf(rawPtr)->owner;
+                if (!owner || owner == cache || !pushRemoteFree(*owner, slotOf(rawPtr)))
+                {
+                    // 本地缓存已满时，先批量归还一部分给全局空闲列表
+                    if (cache->objects.size() >= m_threadCacheSize)
+                    {
+                        flushThreadCache(*cache, threadCacheBatch());
+                    }
+                    cache->objects.push_back(rawPtr);
+                    cache->count.store(cache->objects.size(), std::memory_order_relaxed);
+                }
+                // 放回之后才出现的等待者看不到线程本地缓存与远程释放列表中的对象，把它们交给等待者
+                if (hasWaiters())
+                {
+                    flushThreadCache(*cache, cache->objects.size());
+                    reclaimRemoteFree();
+                }
+                // 对象已经回到缓存，只修改本线程缓存中的计数
+                keepAlive = removeOutstanding(1, cache);
+                return;
+            }
+
+            // 无锁空闲列表
+            if constexpr (Policy::lockFree)
+            {
+                Slot* slot = slotOf(rawPtr);
+
+                // 如果空闲对象数量小于最大大小，将对象放回空闲列表
+                if (m_availableCount.load(std::memory_order_relaxed) < m_maxSize)
+                {
+                    trace(TraceEvent::Release, rawPtr, callSite);
+                    m_availableCount.fetch_add(1, std::memory_order_relaxed);
+                    m_freeList.push(slot);
+                }
+                else
+                {
+                    // 如果空闲列表已满，销毁对象
+                    trace(TraceEvent::Drop, rawPtr, callSite);
+                    destroyObject(rawPtr);
+                    countStat(&StatShard::drops);
+                }
+                // 放回空闲列表之后才出现的等待者
+                if (hasWaiters())
+                {
+                    serveWaiters();
+                }
+                adaptTrim();
+                keepAlive = removeOutstanding(1);
+                return;
+            }
+
+            bool pooled = false;
+            {
+                // 加锁，保证对对象池的操作线程安全，锁内只做放回空闲列表的操作
+                std::unique_lock<Mutex> lock = lockPool();
+                // 如果对象池的大小小于最大大小
+                if (m_pool.size() < m_maxSize)
+                {
+                    // std::cout << "emplace_back" << std::endl;
+                    // 将对象放回对象池，其它线程解锁后才能取到它
+                    trace(TraceEvent::Release, rawPtr, callSite);
+                    m_pool.emplace_back(rawPtr);
+                    m_availableCount.store(m_pool.size(), std::memory_order_relaxed);
+                    pooled = true;
+                }
+            }
+            if (!pooled)
+            {
+                // 如果对象池已满，在锁外销毁对象
+                trace(TraceEvent::Drop, rawPtr, callSite);
+                destroyObject(rawPtr);
+                countStat(&StatShard::drops);
+            }
+            // 放回空闲列表之后才出现的等待者，对象被销毁时已由 discardSlot() 处理
+            if (pooled && hasWaiters())
+            {
+                serveWaiters();
+            }
+            adaptTrim();
+            // 对象处理完后才减少计数，此后不再访问对象池
+            keepAlive = removeOutstanding(1);
+        }
+
+        // 延迟回收对象，delay 之后对象才会回到空闲列表，期间不会被再次获取
+        // 对象放入时间轮后由对象池持有，clear() 或对象池析构时立即销毁
+        void release(std::unique_ptr<T, CustomDeleter> ptr, std::chrono::milliseconds delay)
+        {
+            // 不需要延迟时立即回收
+            if (delay <= std::chrono::milliseconds::zero())
+            {
+                release(std::move(ptr));
+                return;
+            }
+            // 如果对象指针为空，直接返回
+            if (!ptr) return;
+
+            T* rawPtr = ptr.release();
+            std::shared_ptr<BasicObjectPool> keepAlive;
+
+            // 通过槽内的空闲标记检测重复释放，对象已经是空闲状态时直接返回
+            if (!markReleased(rawPtr)) return;
+            countStat(&StatShard::releases);
+            trace(TraceEvent::Release, rawPtr, sampleCallSite(CPPOBJECTPOOL_CALL_SITE()));
+
+            {
+                std::lock_guard<std::mutex> lock(m_delayMutex);
+                if (m_delayWheel.empty())
+                {
+                    m_delayWheel.resize(std::max<size_t>(1, Policy::delayWheelSize));
+                }
+                // 多加一个刻度，保证对象在时间轮上停留的时间不少于 delay
+                uint64_t deadline = delayTick() + static_cast<uint64_t>(delay.count()) + 1;
+                m_delayWheel[deadline % m_delayWheel.size()].push_back(DelayedEntry{ rawPtr, deadline });
+                m_delayedCount.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // 顺便回收已到期的对象
+            processDelayed();
+            // 阻塞等待的线程按时间轮的刻度轮询，异步等待者由时间轮定时器推进，对象到期后才能被取走
+            if (hasWaiters())
+            {
+                pollWaiters();
+            }
+            // 对象已由时间轮持有，最后减少计数，此后不再访问对象池
+            keepAlive = removeOutstanding(1);
+        }
+    };
+
+    // 使用互斥锁保护空闲列表的对象池
+    template <typename T, typename... Args>
+    using ObjectPool = BasicObjectPool<T, DefaultPoolPolicy, Args...>;
+
+    // 处理函数在编译期确定的对象池，例如 HookedObjectPool<Message, NoHook, ResetMessage>
+    template <typename T, typename PreHook = NoHook, typename PostHook = NoHook, typename FinalHook = NoHook>
+    using HookedObjectPool = BasicObjectPool<T, HookPolicy<PreHook, PostHook, FinalHook>>;
+
+    // 使用无锁空闲列表的对象池
+    template <typename T, typename... Args>
+    using LockFreeObjectPool = BasicObjectPool<T, LockFreePoolPolicy, Args...>;
+
+    // 对象存放在连续 slab 块中的对象池
+    template <typename T, typename... Args>
+    using SlabObjectPool = BasicObjectPool<T, SlabPoolPolicy, Args...>;
+
+    // 字段按缓存行布局、对象按缓存行对齐的对象池
+    template <typename T, typename... Args>
+    using CacheAlignedObjectPool = BasicObjectPool<T, CacheAlignedPoolPolicy, Args...>;
+
+    // 使用 TTAS 自旋锁保护空闲列表的对象池
+    template <typename T, typename... Args>
+    using SpinLockObjectPool = BasicObjectPool<T, LockPolicy<SpinLock>, Args...>;
+
+    // 使用先自旋后睡眠的自适应锁保护空闲列表的对象池
+    template <typename T, typename... Args>
+    using AdaptiveLockObjectPool = BasicObjectPool<T, LockPolicy<AdaptiveMutex>, Args...>;
+
+    // 支持 acquire_shared() 的对象池
+    template <typename T, typename... Args>
+    using SharedObjectPool = BasicObjectPool<T, SharedPoolPolicy, Args...>;
+
+    // 分片对象池的公共部分：持有一组子对象池，汇总统计信息并把设置转发给所有分片
+    // 对象释放时总是回到分配它的分片，句柄类型与对应的 BasicObjectPool 相同
+    template <typename T, typename Policy, typename... Args>
+    class ShardedPoolBase
+    {
+    public:
+        // 子对象池
+        using Shard = BasicObjectPool<T, Policy, Args...>;
+        using CustomDeleter = typename Shard::CustomDeleter;
+        using PreProcess = typename Shard::PreProcess;
+        using PostProcess = typename Shard::PostProcess;
+        using FinalProcess = typename Shard::FinalProcess;
+
+        // 释放对象，对象回到分配它的分片
+        void release(std::unique_ptr<T, CustomDeleter> ptr)
+        {
+            ptr.reset();
+        }
+
+        // 获取所有分片中空闲对象的数量
+        size_t getAvailableCount() const
+        {
+            size_t count = 0;
+            for (const auto& shard : m_shards)
+            {
+                count += shard->getAvailableCount();
+            }
+            return count;
+        }
+
+        // 汇总所有分片的统计信息，peakOutstanding 为各分片峰值之和
+        // failures 包含本地分片耗尽后转向其它分片的次数
+        PoolStats stats() const
+        {
+            PoolStats result;
+            for (const auto& shard : m_shards)
+            {
+                PoolStats s = shard->stats();
+                result.acquires += s.acquires;
+                result.hits += s.hits;
+                result.creates += s.creates;
+                result.failures += s.failures;
+                result.releases += s.releases;
+                result.drops += s.drops;
+                result.contendedLocks += s.contendedLocks;
+                result.trimmed += s.trimmed;
+                result.outstanding += s.outstanding;
+                result.peakOutstanding += s.peakOutstanding;
+                result.available += s.available;
+                result.allocated += s.allocated;
+                for (size_t i = 0; i < kLatencyBuckets; ++i)
+                {
+                    result.acquireLatency[i] += s.acquireLatency[i];
+                }
+            }
+            return result;
+        }
+
+        // 清空所有分片
+        void clear()
+        {
+            for (auto& shard : m_shards)
+            {
+                shard->clear();
+            }
+        }
+
+        // 设置所有分片的预处理函数
+        void setPreProcess(PreProcess preProcess)
+        {
+            for (auto& shard : m_shards)
+            {
+                shard->setPreProcess(preProcess);
+            }
+        }
+
+        // 设置所有分片的后处理函数
+        void setPostProcess(PostProcess postProcess)
+        {
+            for (auto& shard : m_shards)
+            {
+                shard->setPostProcess(postProcess);
+            }
+        }
+
+        // 设置所有分片的最终处理函数
+        void setFinalProcess(FinalProcess finalProcess)
+        {
+            for (auto& shard : m_shards)
+            {
+                shard->setFinalProcess(finalProcess);
+            }
+        }
+
+        // 设置所有分片的线程本地缓存深度
+        void setThreadCacheSize(size_t depth)
+        {
+            for (auto& shard : m_shards)
+            {
+                shard->setThreadCacheSize(depth);
+            }
+        }
+
+        // 设置所有分片的自适应回收策略，minIdle 平均分配到各分片
+        void setTrimPolicy(std::chrono::milliseconds window, size_t minIdle = 0)
+        {
+            for (size_t i = 0; i < m_shards.size(); ++i)
+            {
+                m_shards[i]->setTrimPolicy(window, minIdle / m_shards.size() + (i < minIdle % m_shards.size() ? 1 : 0));
+            }
+        }
+
+        // 立即回收所有分片中的空闲对象，返回销毁的对象数量
+        size_t trim()
+        {
+            size_t count = 0;
+            for (auto& shard : m_shards)
+            {
+                count += shard->trim();
+            }
+            return count;
+        }
+
+        // 依次访问各分片中已被获取的对象，返回访问的数量，见 BasicObjectPool::for_each_outstanding()
+        template <typename Func>
+        size_t for_each_outstanding(Func&& fn)
+        {
+            size_t count = 0;
+            for (auto& shard : m_shards)
+            {
+                count += shard->for_each_outstanding(fn);
+            }
+            return count;
+        }
+
+        // 依次访问各分片中的空闲对象，返回访问的数量
+        template <typename Func>
+        size_t for_each_idle(Func&& fn)
+        {
+            size_t count = 0;
+            for (auto& shard : m_shards)
+            {
+                count += shard->for_each_idle(fn);
+            }
+            return count;
+        }
+
+        // 获取指定的分片
+        Shard& shard(size_t index)
+        {
+            return *m_shards[index];
+        }
+
+        // 各分片，句柄通过槽内回指直接归还给分片，分片在仍有对象在外时保持存活
+        std::vector<std::shared_ptr<Shard>> m_shards;
+    };
+
+    // 按 NUMA 节点分片的对象池：每个节点一个子对象池，对象在所属节点的内存中分配
+    // acquire 优先使用调用线程所在节点的分片，本节点分片耗尽时才从其它节点借用空闲对象
+    // 对象释放时总是回到分配它的分片，句柄类型与对应的 BasicObjectPool 相同
+    template <typename T, typename Policy, typename... Args>
+    class BasicNumaObjectPool : public ShardedPoolBase<T, Policy, Args...>
+    {
+    public:
+        using Shard = typename ShardedPoolBase<T, Policy, Args...>::Shard;
+        using CustomDeleter = typename Shard::CustomDeleter;
+        using ShardedPoolBase<T, Policy, Args...>::m_shards;
+
+        // 静态工厂方法，initialSize 与 maxSize 平均分配到各个节点
+        static std::shared_ptr<BasicNumaObjectPool> create(
+            // 对象池的初始大小，默认为 10
+            size_t initialSize = 10,
+            // 对象池的最大大小，默认为 size_t 类型的最大值
+            size_t maxSize = std::numeric_limits<size_t>::max(),
+            // 对象构造函数的参数，每个分片保存一份拷贝
+            Args&&... args)
+        {
+            return std::shared_ptr<BasicNumaObjectPool>(new BasicNumaObjectPool(
+                initialSize, maxSize, numaNodeCount(), std::forward<Args>(args)...));
+        }
+
+        // 获取对象：先尝试本节点分片，再依次从其它节点借用空闲对象，最后在仍有名额的分片中创建
+        std::unique_ptr<T, CustomDeleter> acquire()
+        {
+            size_t local = currentNumaNode() % m_shards.size();
+            if (auto ptr = m_shards[local]->acquire())
+            {
+                return ptr;
+            }
+            // 本节点分片已达到最大大小，优先借用其它节点的空闲对象
+            for (size_t i = 1; i < m_shards.size(); ++i)
+            {
+                Shard& shard = *m_shards[(local + i) % m_shards.size()];
+                if (shard.getAvailableCount() > 0)
+                {
+                    if (auto ptr = shard.acquire())
+                    {
+                        return ptr;
+                    }
+                }
+            }
+            // 所有节点都没有空闲对象时，在其它仍有名额的分片中创建
+            for (size_t i = 1; i < m_shards.size(); ++i)
+            {
+                if (auto ptr = m_shards[(local + i) % m_shards.size()]->acquire())
+                {
+                    return ptr;
+                }
+            }
+            return nullptr;
+        }
+
+        // 分片(节点)的数量
+        size_t getNodeCount() const
+        {
+            return m_shards.size();
+        }
+
+        // 构造函数，nodeCount 为分片数量
+        BasicNumaObjectPool(size_t initialSize, size_t maxSize, size_t nodeCount, Args&&... args)
+            : m_budget(std::make_shared<PoolBudget>(maxSize))
+        {
+            nodeCount = std::max<size_t>(1, nodeCount);
+            // 向上取整，保证各分片合计能容纳 maxSize 个对象，总数由共享的上限限制
+            size_t shardMax = maxSize / nodeCount + (maxSize % nodeCount != 0 ? 1 : 0);
+            size_t shardInitial = initialSize / nodeCount;
+            m_shards.reserve(nodeCount);
+            for (size_t node = 0; node < nodeCount; ++node)
+            {
+                // 每个分片持有一份构造参数的拷贝
+                m_shards.push_back(Shard::create(0, shardMax, Args(args)...));
+                m_shards.back()->setNumaNode(node);
+                m_shards.back()->setBudget(m_budget);
+                // 初始对象在绑定节点之后创建，余数分给前面的节点
+                m_shards.back()->reserve(shardInitial + (node < initialSize % nodeCount ? 1 : 0));
+            }
+        }
+
+        // 所有分片共享的对象数量上限
+        std::shared_ptr<PoolBudget> m_budget;
+    };
+
+    // 按 CPU 分片的对象池：K 个相互独立的子对象池，各自有自己的锁与空闲列表，可以代替线程本地缓存
+    // acquire 使用调用线程所在 CPU 对应的分片，本地分片没有空闲对象时依次从相邻分片窃取，
+    // 所有分片都没有空闲对象时才在本地分片中创建；所有分片共享一个全局的 maxSize
+    template <typename T, typename Policy, typename... Args>
+    class BasicShardedObjectPool : public ShardedPoolBase<T, Policy, Args...>
+    {
+    public:
+        using Shard = typename ShardedPoolBase<T, Policy, Args...>::Shard;
+        using CustomDeleter = typename Shard::CustomDeleter;
+        using ShardedPoolBase<T, Policy, Args...>::m_shards;
+
+        // 静态工厂方法，分片数量为硬件线程数，initialSize 平均分配到各个分片
+        static std::shared_ptr<BasicShardedObjectPool> create(
+            // 对象池的初始大小，默认为 10
+            size_t initialSize = 10,
+            // 对象池的最大大小(所有分片合计)，默认为 size_t 类型的最大值
+            size_t maxSize = std::numeric_limits<size_t>::max(),
+            // 对象构造函数的参数，每个分片保存一份拷贝
+            Args&&... args)
+        {
+            return std::shared_ptr<BasicShardedObjectPool>(new BasicShardedObjectPool(
+                initialSize, maxSize, std::thread::hardware_concurrency(), std::forward<Args>(args)...));
+        }
+
+        // 获取对象：本地分片 -> 相邻分片中的空闲对象 -> 在全局 maxSize 范围内于本地分片创建
+        std::unique_ptr<T, CustomDeleter> acquire()
+        {
+            size_t local = currentCpu() % m_shards.size();
+            // 空闲数量只是近似值，读到非零后仍可能取不到，此时继续窃取
+            for (size_t i = 0; i < m_shards.size(); ++i)
+            {
+                Shard& shard = *m_shards[(local + i) % m_shards.size()];
+                if (shard.getAvailableCount() > 0)
+                {
+                    if (auto ptr = shard.acquire())
+                    {
+                        return ptr;
+                    }
+                }
+            }
+            return m_shards[local]->acquire();
+        }
+
+        // 分片的数量
+        size_t getShardCount() const
+        {
+            return m_shards.size();
+        }
+
+        // 构造函数，shardCount 为分片数量，每个分片的空闲列表都可以容纳全部 maxSize 个对象
+        BasicShardedObjectPool(size_t initialSize, size_t maxSize, size_t shardCount, Args&&... args)
+            : m_budget(std::make_shared<PoolBudget>(maxSize))
+        {
+            shardCount = std::max<size_t>(1, shardCount);
+            size_t shardInitial = initialSize / shardCount;
+            m_shards.reserve(shardCount);
+            for (size_t i = 0; i < shardCount; ++i)
+            {
+                // 每个分片持有一份构造参数的拷贝
+                m_shards.push_back(Shard::create(0, maxSize, Args(args)...));
+                m_shards.back()->setBudget(m_budget);
+                // 余数分给前面的分片
+                m_shards.back()->reserve(shardInitial + (i < initialSize % shardCount ? 1 : 0));
+            }
+        }
+
+        // 所有分片共享的对象数量上限
+        std::shared_ptr<PoolBudget> m_budget;
+    };
+
+    // 按大小分级的对象池：每个大小级别一个子对象池，级别中的对象以 T(classSize) 构造，
+    // 例如 1K/4K/16K/64K 的缓冲区；acquire(size) 从能容纳 size 的最小级别中获取对象，
+    // 所有级别的句柄类型相同，对象释放时回到所属级别
+    template <typename T, typename Policy>
+    class BasicSizeClassPool : public ShardedPoolBase<T, Policy, size_t>
+    {
+    public:
+        using Shard = typename ShardedPoolBase<T, Policy, size_t>::Shard;
+        using CustomDeleter = typename Shard::CustomDeleter;
+        using ShardedPoolBase<T, Policy, size_t>::m_shards;
+
+        // 静态工厂方法，classSizes 为各个大小级别，每个级别的初始大小与最大大小分别为 initialSize 与 maxSize
+        static std::shared_ptr<BasicSizeClassPool> create(
+            std::vector<size_t> classSizes,
+            // 每个级别的初始大小，默认为 0
+            size_t initialSize = 0,
+            // 每个级别的最大大小，默认为 size_t 类型的最大值
+            size_t maxSize = std::numeric_limits<size_t>::max())
+        {
+            return std::shared_ptr<BasicSizeClassPool>(new BasicSizeClassPool(
+                std::move(classSizes), initialSize, maxSize));
+        }
+
+        // 从能容纳 size 的最小级别中获取对象，size 超过最大的级别或该级别已达到最大大小时返回空指针
+        std::unique_ptr<T, CustomDeleter> acquire(size_t size)
+        {
+            size_t index = classIndex(size);
+            if (index == m_classSizes.size())
+            {
+                return nullptr;
+            }
+            return m_shards[index]->acquire();
+        }
+
+        // 能容纳 size 的最小级别的下标，没有这样的级别时返回级别数量
+        size_t classIndex(size_t size) const
+        {
+            return static_cast<size_t>(std::lower_bound(m_classSizes.begin(), m_classSizes.end(), size) - m_classSizes.begin());
+        }
+
+        // 第 index 个级别的大小
+        size_t getClassSize(size_t index) const
+        {
+            return m_classSizes[index];
+        }
+
+        // 级别的数量
+        size_t getClassCount() const
+        {
+            return m_classSizes.size();
+        }
+
+        // 构造函数，classSizes 会被排序并去重
+        BasicSizeClassPool(std::vector<size_t> classSizes, size_t initialSize, size_t maxSize)
+            : m_classSizes(std::move(classSizes))
+        {
+            std::sort(m_classSizes.begin(), m_classSizes.end());
+            m_classSizes.erase(std::unique(m_classSizes.begin(), m_classSizes.end()), m_classSizes.end());
+            m_shards.reserve(m_classSizes.size());
+            for (size_t classSize : m_classSizes)
+            {
+                m_shards.push_back(Shard::create(initialSize, maxSize, size_t(classSize)));
+            }
+        }
+
+        // 升序排列的各个大小级别
+        std::vector<size_t> m_classSizes;
+    };
+
+    // 按 NUMA 节点分片、对象存放在节点本地 slab 块中的对象池
+    template <typename T, typename... Args>
+    using NumaObjectPool = BasicNumaObjectPool<T, SlabPoolPolicy, Args...>;
+
+    // 按 CPU 分片、每个分片使用互斥锁保护空闲列表的对象池
+    template <typename T, typename... Args>
+    using ShardedObjectPool = BasicShardedObjectPool<T, DefaultPoolPolicy, Args...>;
+
+    // 按大小分级、每个级别使用互斥锁保护空闲列表的对象池
+    template <typename T>
+    using SizeClassObjectPool = BasicSizeClassPool<T, DefaultPoolPolicy>;
+
+    // 容量在编译期确定、不使用任何动态内存的对象池，N 个对象的存储内联在对象池中
+    // 空闲列表是按下标链接的无锁栈，下标类型按 N 选用 uint16_t 或 uint32_t；不需要 std::shared_ptr，
+    // 可以作为全局变量或结构体成员，constexpr 构造函数使全局对象池在编译期完成初始化
+    // 对象在首次被获取时才以 T(args...) 构造，之后一直复用(归还时按 reset_traits 重置)，直到对象池析构；
+    // 对象池析构前所有对象都必须已经归还
+    template <typename T, std::size_t N, typename... Args>
+    class StaticObjectPool
+    {
+        static_assert(N > 0 && N < std::numeric_limits<uint32_t>::max(), "StaticObjectPool capacity out of range");
+
+    public:
+        // 槽下标的类型
+        using Index = typename std::conditional<(N < std::numeric_limits<uint16_t>::max()), uint16_t, uint32_t>::type;
+
+        // 删除器，把对象归还给所属的对象池
+        struct Deleter
+        {
+            StaticObjectPool* pool{ nullptr };
+
+            void operator()(T* ptr) const
+            {
+                pool->release(ptr);
+            }
+        };
+
+        // 对象句柄
+        using Handle = std::unique_ptr<T, Deleter>;
+
+        // 构造函数，args 为对象的构造参数，对象池中不会构造任何对象
+        constexpr explicit StaticObjectPool(Args... args)
+            : m_args(std::move(args)...)
+        {
+        }
+
+        StaticObjectPool(const StaticObjectPool&) = delete;
+        StaticObjectPool& operator=(const StaticObjectPool&) = delete;
+
+        // 析构函数，销毁所有构造过的对象
+        ~StaticObjectPool()
+        {
+            size_t used = std::min(m_used.load(std::memory_order_acquire), N);
+            for (size_t i = 0; i < used; ++i)
+            {
+                if (m_slots[i].constructed)
+                {
+                    m_slots[i].object()->~T();
+                }
+            }
+        }
+
+        // 获取对象，N 个对象都已被获取时返回空指针；构造对象抛出异常时该槽留给之后的获取重试
+        Handle acquire()
+        {
+            Index index = pop();
+            if (index == kNull)
+            {
+                // 空闲列表为空时使用一个从未用过的槽
+                size_t used = m_used.load(std::memory_order_relaxed);
+                do
+                {
+                    if (used >= N)
+                    {
+                        return Handle(nullptr, Deleter{ this });
+                    }
+                } while (!m_used.compare_exchange_weak(used, used + 1, std::memory_order_relaxed));
+                index = static_cast<Index>(used);
+            }
+            else
+            {
+                m_available.fetch_sub(1, std::memory_order_relaxed);
+            }
+            Slot& slot = m_slots[index];
+            if (!slot.constructed)
+            {
+                try
+                {
+                    constructHelper(slot, make_index_sequence<sizeof...(Args)>{});
+                }
+                catch (...)
+                {
+                    // 未构造的槽同样可以放回空闲列表
+                    pushIdle(index);
+                    throw;
+                }
+                slot.constructed = true;
+            }
+            return Handle(slot.object(), Deleter{ this });
+        }
+
+        // 释放对象
+        void release(Handle ptr)
+        {
+            ptr.reset();
+        }
+
+        // 对象池中空闲(包括尚未构造)的对象数量
+        size_t getAvailableCount() const
+        {
+            size_t used = std::min(m_used.load(std::memory_order_relaxed), N);
+            return N - used + m_available.load(std::memory_order_relaxed);
+        }
+
+        // 对象池的容量
+        static constexpr size_t capacity()
+        {
+            return N;
+        }
+
+    private:
+        // 一个对象的存储，对象位于槽的起始位置，因此 T* 与 Slot* 可以互相转换
+        struct Slot
+        {
+            alignas(T) unsigned char storage[sizeof(T)]{};
+            // 空闲列表中下一个槽的下标
+            std::atomic<Index> next{ 0 };
+            // 槽内是否有构造好的对象，只由持有该槽的线程访问
+            bool constructed{ false };
+
+            T* object()
+            {
+                return reinterpret_cast<T*>(storage);
+            }
+        };
+
+        // 空闲列表结束标记
+        static constexpr uint32_t kNull = std::numeric_limits<Index>::max();
+
+        // 归还对象
+        void release(T* ptr)
+        {
+            if (!ptr) return;
+            if constexpr (reset_traits<T>::enabled)
+            {
+                reset_traits<T>::reset(*ptr);
+            }
+            pushIdle(static_cast<Index>(reinterpret_cast<Slot*>(ptr) - m_slots));
+        }
+
+        // 把槽放回空闲列表
+        void pushIdle(Index index)
+        {
+            push(index);
+            m_available.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // 辅助函数，用于展开构造函数参数
+        template <size_t... Is>
+        void constructHelper(Slot& slot, index_sequence<Is...>)
+        {
+            new (slot.storage) T(std::get<Is>(m_args)...);
+        }
+
+        // 栈顶的低 32 位为下标，高 32 位为每次修改都会递增的版本号，用于避免 ABA 问题
+        void push(Index index)
+        {
+            uint64_t head = m_head.load(std::memory_order_relaxed);
+            do
+            {
+                m_slots[index].next.store(static_cast<Index>(head & 0xffffffffu), std::memory_order_relaxed);
+            } while (!m_head.compare_exchange_weak(head, ((head >> 32) + 1) << 32 | index,
+                std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        // 弹出一个槽的下标，空闲列表为空时返回 kNull
+        Index pop()
+        {
+            uint64_t head = m_head.load(std::memory_order_acquire);
+            for (;;)
+            {
+                uint32_t index = static_cast<uint32_t>(head & 0xffffffffu);
+                if (index == kNull)
+                {
+                    return static_cast<Index>(kNull);
+                }
+                // 槽可能已被其它线程弹出，此时读到的 next 会因版本号变化而在 CAS 时被丢弃
+                uint64_t next = m_slots[index].next.load(std::memory_order_relaxed);
+                if (m_head.compare_exchange_weak(head, ((head >> 32) + 1) << 32 | next,
+                    std::memory_order_acquire, std::memory_order_acquire))
+                {
+                    return static_cast<Index>(index);
+                }
+            }
+        }
+
+        // 对象的构造参数
+        std::tuple<Args...> m_args;
+        // 空闲列表的栈顶
+        std::atomic<uint64_t> m_head{ kNull };
+        // 使用过的槽的数量，之后的槽尚未构造对象
+        std::atomic<size_t> m_used{ 0 };
+        // 空闲列表中槽的数量
+        std::atomic<size_t> m_available{ 0 };
+        // 对象存储
+        Slot m_slots[N];
+    };
+
+#if defined(CPPOBJECTPOOL_SHARED_MEMORY)
+    // 存放在命名共享内存(shm_open + mmap)中的跨进程对象池，多个进程映射同一区域后都可以获取和释放对象
+    // 区域内只保存偏移与下标，不保存指针，各进程的映射地址可以不同；进程之间通过 handoff()/adopt() 传递 Ref，
+    // 对象本身不被复制，热路径上没有系统调用
+    // 每个槽有一个租约(代数 + 持有进程的 pid)，recover() 回收已退出进程持有的槽，代数使旧的 Ref 失效
+    // T 必须可平凡复制(不含虚函数，析构函数什么也不做)，且不应包含指向进程私有内存的指针
+    template <typename T>
+    class SharedMemoryObjectPool
+    {
+        static_assert(std::is_trivially_copyable<T>::value && std::is_default_constructible<T>::value,
+            "SharedMemoryObjectPool requires a trivially copyable, default constructible type");
+        static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+            "SharedMemoryObjectPool requires lock-free atomics");
+
+    public:
+        // 删除器，把对象归还给所属的对象池
+        struct Deleter
+        {
+            SharedMemoryObjectPool* pool{ nullptr };
+
+            void operator()(T* ptr) const
+            {
+                pool->release(ptr);
+            }
+        };
+
+        // 对象句柄
+        using Handle = std::unique_ptr<T, Deleter>;
+
+        // 在进程之间传递的对象引用：offset 为对象相对区域起始位置的偏移，generation 为获取时的代数
+        struct Ref
+        {
+            uint64_t offset;
+            uint32_t generation;
+        };
+
+        // 创建名为 name 的共享内存区域并初始化一个容量为 capacity 的对象池，区域已存在时抛出 std::system_error
+        static std::shared_ptr<SharedMemoryObjectPool> create(const std::string& name, size_t capacity)
+        {
+            if (capacity == 0 || capacity >= kNull)
+            {
+                throw std::system_error(EINVAL, std::generic_category(), "SharedMemoryObjectPool capacity out of range");
+            }
+            int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+            if (fd < 0)
+            {
+                throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+            }
+            size_t size = regionSize(capacity);
+            if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+            {
+                int error = errno;
+                ::close(fd);
+                ::shm_unlink(name.c_str());
+                throw std::system_error(error, std::generic_category(), "ftruncate " + name);
+            }
+            void* base = nullptr;
+            try
+            {
+                base = mapRegion(fd, size, name);
+            }
+            catch (...)
+            {
+                // mapRegion 已经关闭了文件描述符，删除刚创建的名字，否则之后的 create() 都会因区域已存在而失败
+                ::shm_unlink(name.c_str());
+                throw;
+            }
+            // 新区域的内容全为 0，只需写入非零字段；其它进程看到 magic 之后才会使用该区域
+            Header* header = new (base) Header;
+            header->capacity = static_cast<uint32_t>(capacity);
+            header->objectSize = sizeof(T);
+            header->objectAlign = alignof(T);
+            header->slotSize = sizeof(Slot);
+            header->head.store(kNull, std::memory_order_relaxed);
+            for (size_t i = 0; i < capacity; ++i)
+            {
+                new (static_cast<unsigned char*>(base) + kSlotsOffset + i * sizeof(Slot)) Slot;
+            }
+            header->magic.store(kMagic, std::memory_order_release);
+            return std::shared_ptr<SharedMemoryObjectPool>(new SharedMemoryObjectPool(base, size));
+        }
+
+        // 映射已存在的对象池，区域的布局与 T 不匹配时抛出 std::system_error(EINVAL)，
+        // 创建方尚未完成初始化时抛出 std::system_error(EAGAIN)，可以稍后重试
+        static std::shared_ptr<SharedMemoryObjectPool> open(const std::string& name)
+        {
+            int fd = ::shm_open(name.c_str(), O_RDWR, 0);
+            if (fd < 0)
+            {
+                throw std::system_error(errno, std::generic_category(), "shm_open " + name);
+            }
+            struct stat st;
+            if (::fstat(fd, &st) != 0)
+            {
+                int error = errno;
+                ::close(fd);
+                throw std::system_error(error, std::generic_category(), "fstat " + name);
+            }
+            size_t size = static_cast<size_t>(st.st_size);
+            if (size < kSlotsOffset)
+            {
+                ::close(fd);
+                throw std::system_error(EAGAIN, std::generic_category(), "SharedMemoryObjectPool not initialized: " + name);
+            }
+            void* base = mapRegion(fd, size, name);
+            std::shared_ptr<SharedMemoryObjectPool> pool(new SharedMemoryObjectPool(base, size));
+            const Header& header = *pool->m_header;
+            if (header.magic.load(std::memory_order_acquire) != kMagic)
+            {
+                throw std::system_error(EAGAIN, std::generic_category(), "SharedMemoryObjectPool not initialized: " + name);
+            }
+            if (header.objectSize != sizeof(T) || header.objectAlign != alignof(T) || header.slotSize != sizeof(Slot)
+                || size < regionSize(header.capacity))
+            {
+                throw std::system_error(EINVAL, std::generic_category(), "SharedMemoryObjectPool layout mismatch: " + name);
+            }
+            return pool;
+        }
+
+        // 删除共享内存区域的名字，已映射的进程不受影响，最后一个进程解除映射后内存才会释放
+        static bool unlink(const std::string& name)
+        {
+            return ::shm_unlink(name.c_str()) == 0;
+        }
+
+        // 区域的大小
+        static constexpr size_t regionSize(size_t capacity)
+        {
+            return kSlotsOffset + capacity * sizeof(Slot);
+        }
+
+        SharedMemoryObjectPool(const SharedMemoryObjectPool&) = delete;
+        SharedMemoryObjectPool& operator=(const SharedMemoryObjectPool&) = delete;
+
+        // 析构函数，解除映射；本进程的句柄必须已经释放，区域中的对象保持原样
+        ~SharedMemoryObjectPool()
+        {
+            ::munmap(m_base, m_size);
+        }
+
+        // 获取对象，所有对象都已被获取时返回空指针
+        Handle acquire()
+        {
+            uint32_t index = pop();
+            if (index == kNull)
+            {
+                // 空闲列表为空时使用一个从未用过的槽，对象在首次使用时值初始化
+                uint32_t used = m_header->used.load(std::memory_order_relaxed);
+                do
+                {
+                    if (used >= m_header->capacity)
+                    {
+                        return Handle(nullptr, Deleter{ this });
+                    }
+                } while (!m_header->used.compare_exchange_weak(used, used + 1, std::memory_order_relaxed));
+                index = used;
+                new (slot(index).storage) T();
+            }
+            else
+            {
+                m_header->available.fetch_sub(1, std::memory_order_relaxed);
+            }
+            // 递增代数并记录持有进程，之前发出的 Ref 随之失效
+            Slot& s = slot(index);
+            uint64_t lease = s.lease.load(std::memory_order_relaxed);
+            s.lease.store(makeLease(generationOf(lease) + 1, m_pid), std::memory_order_relaxed);
+            return Handle(s.object(), Deleter{ this });
+        }
+
+        // 释放对象
+        void release(Handle ptr)
+        {
+            ptr.reset();
+        }
+
+        // 交出对象，返回的 Ref 可以写入进程间的队列或管道，由另一个进程 adopt() 后使用；
+        // 租约在被 adopt() 之前仍记在本进程名下
+        Ref handoff(Handle ptr)
+        {
+            T* raw = ptr.release();
+            if (!raw)
+            {
+                return Ref{ 0, 0 };
+            }
+            Slot* s = reinterpret_cast<Slot*>(raw);
+            return Ref{ offsetOf(s), generationOf(s->lease.load(std::memory_order_relaxed)) };
+        }
+
+        // 接管另一个进程交出的对象，租约转到本进程名下并递增代数，同一个 Ref 只能被接管一次；
+        // Ref 无效或已经失效(对象已被释放、被接管或被 recover() 回收)时返回空指针
+        Handle adopt(Ref ref)
+        {
+            if (ref.offset < kSlotsOffset || (ref.offset - kSlotsOffset) % sizeof(Slot) != 0
+                || (ref.offset - kSlotsOffset) / sizeof(Slot) >= m_header->used.load(std::memory_order_relaxed))
+            {
+                return Handle(nullptr, Deleter{ this });
+            }
+            Slot& s = slot(static_cast<uint32_t>((ref.offset - kSlotsOffset) / sizeof(Slot)));
+            uint64_t lease = s.lease.load(std::memory_order_relaxed);
+            do
+            {
+                if (generationOf(lease) != ref.generation || pidOf(lease) == 0)
+                {
+                    return Handle(nullptr, Deleter{ this });
+                }
+            } while (!s.lease.compare_exchange_weak(lease, makeLease(ref.generation + 1, m_pid),
+                std::memory_order_acquire, std::memory_order_relaxed));
+            return Handle(s.object(), Deleter{ this });
+        }
+
+        // 回收持有进程已经退出的槽，返回回收的数量；可以由监控进程定期调用，或在发现对端崩溃后调用
+        // 崩溃进程正在写入的对象内容不确定，回收时按 reset_traits 重置；pid 被新进程复用时槽要等新进程退出后才能回收
+        size_t recover()
+        {
+            size_t recovered = 0;
+            uint32_t used = std::min(m_header->used.load(std::memory_order_acquire), m_header->capacity);
+            for (uint32_t i = 0; i < used; ++i)
+            {
+                Slot& s = slot(i);
+                uint64_t lease = s.lease.load(std::memory_order_relaxed);
+                uint32_t pid = pidOf(lease);
+                if (pid == 0 || pid == m_pid || processAlive(pid))
+                {
+                    continue;
+                }
+                // 与 adopt() 竞争，只有一方能改变租约
+                if (s.lease.compare_exchange_strong(lease, makeLease(generationOf(lease), 0), std::memory_order_acquire))
+                {
+                    if constexpr (reset_traits<T>::enabled)
+                    {
+                        reset_traits<T>::reset(*s.object());
+                    }
+                    pushIdle(i);
+                    ++recovered;
+                }
+            }
+            return recovered;
+        }
+
+        // 对象池中空闲(包括尚未使用)的对象数量
+        size_t getAvailableCount() const
+        {
+            uint32_t used = std::min(m_header->used.load(std::memory_order_relaxed), m_header->capacity);
+            return m_header->capacity - used + m_header->available.load(std::memory_order_relaxed);
+        }
+
+        // 对象池的容量
+        size_t capacity() const
+        {
+            return m_header->capacity;
+        }
+
+        // 对象在区域中的偏移
+        uint64_t offsetOf(const T* ptr) const
+        {
+            return static_cast<uint64_t>(reinterpret_cast<const unsigned char*>(ptr) - static_cast<const unsigned char*>(m_base));
+        }
+
+    private:
+        // 区域头，位于区域起始位置；空闲列表的栈顶与计数器各占一个缓存行
+        struct Header
+        {
+            // 初始化完成后由创建方写入
+            std::atomic<uint64_t> magic{ 0 };
+            uint32_t capacity{ 0 };
+            uint32_t objectSize{ 0 };
+            uint32_t objectAlign{ 0 };
+            uint32_t slotSize{ 0 };
+            // 空闲列表的栈顶，低 32 位为下标，高 32 位为版本号
+            alignas(kCacheLineSize) std::atomic<uint64_t> head{ 0 };
+            // 使用过的槽的数量，之后的槽尚未构造对象
+            alignas(kCacheLineSize) std::atomic<uint32_t> used{ 0 };
+            // 空闲列表中槽的数量
+            std::atomic<uint32_t> available{ 0 };
+        };
+
+        // 一个对象的存储，对象位于槽的起始位置，因此 T* 与 Slot* 可以互相转换
+        struct Slot
+        {
+            alignas(T) unsigned char storage[sizeof(T)];
+            // 空闲列表中下一个槽的下标
+            std::atomic<uint32_t> next{ 0 };
+            // 租约：高 32 位为代数，每次获取递增；低 32 位为持有进程的 pid，0 表示空闲
+            std::atomic<uint64_t> lease{ 0 };
+
+            T* object()
+            {
+                return reinterpret_cast<T*>(storage);
+            }
+        };
+
+        // 区域已初始化的标记，同时作为布局版本
+        static constexpr uint64_t kMagic = 0x63706f6f6c736d31ull; // "cpoolsm1"
+        // 空闲列表结束标记
+        static constexpr uint32_t kNull = std::numeric_limits<uint32_t>::max();
+        // 第一个槽的偏移
+        static constexpr size_t kSlotsOffset = (sizeof(Header) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+
+        SharedMemoryObjectPool(void* base, size_t size)
+            : m_base(base)
+            , m_size(size)
+            , m_header(static_cast<Header*>(base))
+            , m_pid(static_cast<uint32_t>(::getpid()))
+        {
+        }
+
+        // 映射共享内存对象并关闭文件描述符
+        static void* mapRegion(int fd, size_t size, const std::string& name)
+        {
+            void* base = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            int error = errno;
+            ::close(fd);
+            if (base == MAP_FAILED)
+            {
+                throw std::system_error(error, std::generic_category(), "mmap " + name);
+            }
+            return base;
+        }
+
+        static uint64_t makeLease(uint32_t generation, uint32_t pid)
+        {
+            return static_cast<uint64_t>(generation) << 32 | pid;
+        }
+
+        static uint32_t generationOf(uint64_t lease)
+        {
+            return static_cast<uint32_t>(lease >> 32);
+        }
+
+        static uint32_t pidOf(uint64_t lease)
+        {
+            return static_cast<uint32_t>(lease);
+        }
+
+        // 进程是否仍然存在；没有权限向其发送信号(EPERM)说明进程存在
+        static bool processAlive(uint32_t pid)
+        {
+            return ::kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+        }
+
+        Slot& slot(uint32_t index) const
+        {
+            return *reinterpret_cast<Slot*>(static_cast<unsigned char*>(m_base) + kSlotsOffset + index * sizeof(Slot));
+        }
+
+        uint64_t offsetOf(const Slot* s) const
+        {
+            return offsetOf(reinterpret_cast<const T*>(s));
+        }
+
+        // 归还对象，清除租约后放回空闲列表；重复释放(租约已清除)时直接返回
+        void release(T* ptr)
+        {
+            if (!ptr) return;
+            Slot* s = reinterpret_cast<Slot*>(ptr);
+            uint64_t lease = s->lease.load(std::memory_order_relaxed);
+            do
+            {
+                if (pidOf(lease) == 0)
+                {
+                    return;
+                }
+            } while (!s->lease.compare_exchange_weak(lease, makeLease(generationOf(lease), 0), std::memory_order_relaxed));
+            if constexpr (reset_traits<T>::enabled)
+            {
+                reset_traits<T>::reset(*ptr);
+            }
+            pushIdle(static_cast<uint32_t>((offsetOf(s) - kSlotsOffset) / sizeof(Slot)));
+        }
+
+        // 把槽放回空闲列表
+        void pushIdle(uint32_t index)
+        {
+            push(index);
+            m_header->available.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // 与 StaticObjectPool 相同的带版本号的下标栈，链接只使用下标，与映射地址无关
+        void push(uint32_t index)
+        {
+            uint64_t head = m_header->head.load(std::memory_order_relaxed);
+            do
+            {
+                slot(index).next.store(static_cast<uint32_t>(head & 0xffffffffu), std::memory_order_relaxed);
+            } while (!m_header->head.compare_exchange_weak(head, ((head >> 32) + 1) << 32 | index,
+                std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        // 弹出一个槽的下标，空闲列表为空时返回 kNull
+        uint32_t pop()
+        {
+            uint64_t head = m_header->head.load(std::memory_order_acquire);
+            for (;;)
+            {
+                uint32_t index = static_cast<uint32_t>(head & 0xffffffffu);
+                if (index == kNull)
+                {
+                    return kNull;
+                }
+                // 槽可能已被其它进程弹出，此时读到的 next 会因版本号变化而在 CAS 时被丢弃
+                uint64_t next = slot(index).next.load(std::memory_order_relaxed);
+                if (m_header->head.compare_exchange_weak(head, ((head >> 32) + 1) << 32 | next,
+                    std::memory_order_acquire, std::memory_order_acquire))
+                {
+                    return index;
+                }
+            }
+        }
+
+        // 映射的起始地址与大小
+        void* m_base;
+        size_t m_size;
+        // 区域头
+        Header* m_header;
+        // 本进程的 pid，写入租约
+        uint32_t m_pid;
+    };
+#endif
 }
 #endif // __CPPOBJECTPOOL_HPP__
@@ -0,0 +1,1180 @@
+// cppobjectpool 的回归测试，每个用例失败时输出用例名并以非零状态退出
+// 编译：g++ -std=c++17 -O1 -g -fsanitize=address,undefined -I. tests/cppobjectpool_test.cpp -pthread -o cppobjectpool_test
+
+#include "cppobjectpool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // 检查条件，不满足时输出位置并退出
+#define CHECK(condition)                                                                        \
+    do                                                                                          \
+    {                                                                                           \
+        if (!(condition))                                                                       \
+        {                                                                                       \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);  \
+            std::exit(1);                                                                       \
+        }                                                                                       \
+    } while (0)
+
+    // 被池化的对象
+    struct Payload
+    {
+        char data[64];
+    };
+
+    // 无锁模式下 trim()/clear() 与并发的 acquire/release 竞争，销毁的对象所在的槽不能在其它线程 pop 时被释放
+    void lockFreeTrimAndClearRace()
+    {
+        auto pool = cppobjectpool::LockFreeObjectPool<Payload>::create(64, 256);
+        pool->setTrimPolicy(std::chrono::milliseconds(0));
+        std::atomic<bool> stop{ false };
+        std::vector<std::thread> workers;
+        for (int i = 0; i < 4; ++i)
+        {
+            workers.emplace_back([&] {
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    auto a = pool->acquire();
+                    auto b = pool->acquire();
+                    a->data[0] = 1;
+                    pool->release(std::move(a));
+                    pool->release(std::move(b));
+                }
+            });
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+        for (int i = 0; std::chrono::steady_clock::now() < deadline; ++i)
+        {
+            if (i % 2 == 0)
+            {
+                pool->trim();
+            }
+            else
+            {
+                pool->clear();
+            }
+        }
+        stop = true;
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+        CHECK(pool->stats().outstanding == 0);
+    }
+
+    // 构造若干次之后抛出异常的对象，live 记录当前存活的对象数量
+    struct Fragile
+    {
+        static inline std::atomic<int> live{ 0 };
+        static inline std::atomic<int> budget{ 0 };
+
+        Fragile()
+        {
+            if (budget.fetch_sub(1) <= 0)
+            {
+                throw std::runtime_error("Fragile");
+            }
+            ++live;
+        }
+        ~Fragile()
+        {
+            --live;
+        }
+    };
+
+    // acquire_n 创建对象时抛出异常，已经从空闲列表取出和已经创建的对象都要回到对象池
+    template <typename Pool>
+    void acquireNThrowingConstructor()
+    {
+        Fragile::budget = 3;
+        {
+            auto pool = Pool::create(2, 10);
+            std::vector<std::unique_ptr<Fragile, typename Pool::CustomDeleter>> out;
+            bool thrown = false;
+            try
+            {
+                pool->acquire_n(5, std::back_inserter(out));
+            }
+            catch (const std::runtime_error&)
+            {
+                thrown = true;
+            }
+            CHECK(thrown);
+            CHECK(out.empty());
+            CHECK(pool->stats().outstanding == 0);
+            CHECK(pool->getAvailableCount() == 3);
+            CHECK(Fragile::live == 3);
+            // 名额已经撤销，回到空闲列表的对象可以被再次获取
+            Fragile::budget = 7;
+            CHECK(pool->acquire_n(10, std::back_inserter(out)) == 10);
+            pool->release_n(out);
+        }
+        CHECK(Fragile::live == 0);
+    }
+
+    // 添加分区后不指定分区的批量获取只能使用共享名额，不能占用分区保留的名额
+    void acquireNRespectsReservation()
+    {
+        auto pool = cppobjectpool::ObjectPool<Payload>::create(0, 4);
+        size_t hi = pool->addPartition("hi", 2);
+        std::vector<std::unique_ptr<Payload, cppobjectpool::ObjectPool<Payload>::CustomDeleter>> out;
+        CHECK(pool->acquire_n(4, std::back_inserter(out)) == 2);
+        auto a = pool->acquire_partition(hi);
+        auto b = pool->acquire_partition(hi);
+        CHECK(a && b);
+        CHECK(!pool->acquire());
+        pool->release_n(out);
+        CHECK(pool->acquire_n(4, std::back_inserter(out)) == 2);
+    }
+
+    // 分区的对象释放时不能交给共享名额已用完的等待者，等待者只能收到共享名额内的对象
+    void waiterRespectsReservation()
+    {
+        auto pool = cppobjectpool::ObjectPool<Payload>::create(0, 2);
+        size_t hi = pool->addPartition("hi", 1);
+        auto shared = pool->acquire();
+        auto reserved = pool->acquire_partition(hi);
+        CHECK(shared && reserved);
+        std::atomic<bool> served{ false };
+        std::thread waiter([&] {
+            auto obj = pool->acquire_wait();
+            CHECK(obj);
+            served = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        pool->release(std::move(reserved));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        CHECK(!served);
+        CHECK(pool->stats().partitions[hi].used == 0);
+        reserved = pool->acquire_partition(hi);
+        CHECK(reserved);
+        CHECK(pool->stats().partitions[hi].used == 1);
+        pool->release(std::move(shared));
+        waiter.join();
+        CHECK(served);
+        CHECK(pool->stats().partitions[hi].used == 1);
+    }
+
+    // 线程本地缓存中的空闲对象不会延长对象池的生命周期，用户放弃对象池后最后一个在外的对象归还时对象池随即析构
+    void threadCacheDoesNotPinPool()
+    {
+        auto pool = cppobjectpool::ObjectPool<Fragile>::create(0, 16);
+        pool->setThreadCacheSize(8);
+        std::weak_ptr<cppobjectpool::ObjectPool<Fragile>> weak = pool;
+        Fragile::budget = 16;
+        auto held = pool->acquire();
+        std::atomic<bool> cached{ false };
+        std::atomic<bool> done{ false };
+        std::thread other([&] {
+            // 在其它线程获取并释放，对象留在该线程的缓存中，线程保持存活直到检查结束
+            {
+                auto a = pool->acquire();
+                auto b = pool->acquire();
+            }
+            cached = true;
+            while (!done)
+            {
+                std::this_thread::yield();
+            }
+        });
+        while (!cached)
+        {
+            std::this_thread::yield();
+        }
+        {
+            auto a = pool->acquire();
+            auto b = pool->acquire();
+        }
+        CHECK(pool->stats().outstanding == 1);
+        pool.reset();
+        CHECK(weak.expired());
+        // 在外的对象仍可以使用与归还，对象池在它归还之前不会析构
+        CHECK(Fragile::live == 5);
+        held.reset();
+        CHECK(Fragile::live == 0);
+        done = true;
+        other.join();
+    }
+
+    // 对象池析构后，新的对象池复用它在线程本地表中的下标，当前线程的过期表项不会被当作新对象池的缓存
+    void threadCacheIndexReused()
+    {
+        using Pool = cppobjectpool::ObjectPool<Payload>;
+        for (int round = 0; round < 3; ++round)
+        {
+            auto pool = Pool::create(0, 16);
+            pool->setThreadCacheSize(4);
+            CHECK(pool->getAvailableCount() == 0);
+            {
+                auto a = pool->acquire();
+                auto b = pool->acquire();
+                CHECK(pool->stats().outstanding == 2);
+            }
+            CHECK(pool->stats().outstanding == 0);
+            CHECK(pool->getAvailableCount() == 2);
+            CHECK(pool->stats().creates == 2);
+        }
+    }
+
+    // 经线程本地缓存获取的对象在其它线程释放，计数分散在各线程的缓存中；
+    // 用户放弃对象池后按任意顺序归还，最后一个对象归还时对象池析构且只析构一次
+    void crossThreadReleaseAfterDetach()
+    {
+        auto pool = cppobjectpool::ObjectPool<Fragile>::create(0, 64);
+        pool->setThreadCacheSize(8);
+        Fragile::budget = 64;
+        std::vector<std::unique_ptr<Fragile, cppobjectpool::ObjectPool<Fragile>::CustomDeleter>> held;
+        std::thread producer([&] {
+            for (int i = 0; i < 32; ++i)
+            {
+                auto ptr = pool->acquire();
+                if (i % 2 == 0)
+                {
+                    held.push_back(std::move(ptr));
+                }
+            }
+        });
+        producer.join();
+        for (int i = 0; i < 8; ++i)
+        {
+            held.push_back(pool->acquire());
+        }
+        // 其它线程获取的对象在本线程释放，本线程缓存中的计数为"负"
+        for (int i = 0; i < 4; ++i)
+        {
+            held.erase(held.begin());
+        }
+        CHECK(pool->stats().outstanding == held.size());
+        std::weak_ptr<cppobjectpool::ObjectPool<Fragile>> weak = pool;
+        pool.reset();
+        CHECK(weak.expired());
+        std::thread consumer([&] {
+            while (held.size() > 1)
+            {
+                held.pop_back();
+                CHECK(Fragile::live > 0);
+            }
+        });
+        consumer.join();
+        CHECK(Fragile::live > 0);
+        held.clear();
+        CHECK(Fragile::live == 0);
+    }
+
+    // 只有一个对象时多个线程轮流等待与释放，释放方与新入队的等待者竞争时对象也不能滞留在空闲列表中
+    template <typename Pool>
+    void waitersNeverStall(size_t threadCacheSize)
+    {
+        auto pool = Pool::create(0, 1);
+        pool->setThreadCacheSize(threadCacheSize);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 3; ++t)
+        {
+            threads.emplace_back([&] {
+                for (int i = 0; i < 5000; ++i)
+                {
+                    auto obj = pool->try_acquire_for(std::chrono::seconds(2));
+                    CHECK(obj);
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        CHECK(pool->stats().outstanding == 0);
+    }
+
+    // 按事件类型计数的追踪器
+    struct CountingTracer
+    {
+        static inline std::atomic<int> counts[6]{};
+        // 带调用点的 Drop 事件数量
+        static inline std::atomic<int> dropsWithCallSite{ 0 };
+
+        void operator()(cppobjectpool::TraceEvent event, uint64_t, const void*, const void* callSite) const
+        {
+            ++counts[static_cast<int>(event)];
+            if (event == cppobjectpool::TraceEvent::Drop && callSite)
+            {
+                ++dropsWithCallSite;
+            }
+        }
+
+        static int count(cppobjectpool::TraceEvent event)
+        {
+            return counts[static_cast<int>(event)];
+        }
+    };
+
+    // 每个回到对象池的对象发出一次 Release，交给等待者的对象发出 AcquireHit，批量释放同样发出 Release，
+    // 批量释放时空闲列表放不下而销毁的对象发出带调用点的 Drop
+    void traceEventsOnEveryPath()
+    {
+        using cppobjectpool::TraceEvent;
+        using Pool = cppobjectpool::BasicObjectPool<Payload, cppobjectpool::TracePolicy<CountingTracer, 0>>;
+        auto pool = Pool::create(0, 1);
+        auto held = pool->acquire();
+        CHECK(CountingTracer::count(TraceEvent::AcquireMiss) == 1);
+        std::thread waiter([&] {
+            auto obj = pool->acquire_wait();
+            CHECK(obj);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        pool->release(std::move(held));
+        waiter.join();
+        CHECK(CountingTracer::count(TraceEvent::AcquireHit) == 1);
+        CHECK(CountingTracer::count(TraceEvent::Release) == 2);
+        std::vector<std::unique_ptr<Payload, Pool::CustomDeleter>> out;
+        CHECK(pool->acquire_n(1, std::back_inserter(out)) == 1);
+        pool->release_n(out);
+        CHECK(CountingTracer::count(TraceEvent::AcquireHit) == 2);
+        CHECK(CountingTracer::count(TraceEvent::Release) == 3);
+        CHECK(CountingTracer::count(TraceEvent::Drop) == 0);
+
+        // 初始对象多于 maxSize，批量归还时只有一个放得回空闲列表，每次都采样调用点
+        using SampledPool = cppobjectpool::BasicObjectPool<Payload, cppobjectpool::TracePolicy<CountingTracer, 1>>;
+        auto sampled = SampledPool::create(3, 1);
+        std::vector<std::unique_ptr<Payload, SampledPool::CustomDeleter>> batch;
+        CHECK(sampled->acquire_n(3, std::back_inserter(batch)) == 3);
+        sampled->release_n(batch);
+        CHECK(CountingTracer::count(TraceEvent::Release) == 4);
+        CHECK(CountingTracer::count(TraceEvent::Drop) == 2);
+        CHECK(CountingTracer::dropsWithCallSite == 2);
+    }
+
+    // maxSize 不能被节点数整除时，各节点分片合计给出的对象也不超过 maxSize
+    void numaPoolRespectsMaxSize()
+    {
+        auto pool = std::make_shared<cppobjectpool::NumaObjectPool<Payload>>(0, 3, 2);
+        CHECK(pool->getNodeCount() == 2);
+        std::vector<std::unique_ptr<Payload, cppobjectpool::NumaObjectPool<Payload>::CustomDeleter>> held;
+        while (auto ptr = pool->acquire())
+        {
+            held.push_back(std::move(ptr));
+            CHECK(held.size() <= 3);
+        }
+        CHECK(held.size() == 3);
+        CHECK(pool->stats().outstanding == 3);
+        // 归还之后名额可以被任意节点重新使用
+        held.clear();
+        for (int i = 0; i < 3; ++i)
+        {
+            held.push_back(pool->acquire());
+            CHECK(held.back());
+        }
+        CHECK(!pool->acquire());
+    }
+
+    // slab 模式下初始对象构造在同一块连续内存中，间距固定；被销毁对象的槽留给之后创建的对象复用
+    void slabObjectsAreContiguous()
+    {
+        using Pool = cppobjectpool::SlabObjectPool<Payload>;
+        auto pool = Pool::create(8, 64);
+        std::vector<std::unique_ptr<Payload, Pool::CustomDeleter>> held;
+        std::vector<uintptr_t> addresses;
+        for (int i = 0; i < 8; ++i)
+        {
+            held.push_back(pool->acquire());
+            addresses.push_back(reinterpret_cast<uintptr_t>(held.back().get()));
+        }
+        CHECK(pool->stats().creates == 0);
+        std::sort(addresses.begin(), addresses.end());
+        uintptr_t stride = addresses[1] - addresses[0];
+        CHECK(stride >= sizeof(Payload));
+        for (size_t i = 1; i < addresses.size(); ++i)
+        {
+            CHECK(addresses[i] - addresses[i - 1] == stride);
+        }
+        held.clear();
+        pool->clear();
+        CHECK(pool->getRealAllockedCount() == 0);
+        for (int i = 0; i < 8; ++i)
+        {
+            held.push_back(pool->acquire());
+            CHECK(std::binary_search(addresses.begin(), addresses.end(), reinterpret_cast<uintptr_t>(held.back().get())));
+        }
+    }
+
+    // 编译期处理函数的调用次数
+    struct HookCounts
+    {
+        static inline int pre = 0;
+        static inline int post = 0;
+        static inline int final = 0;
+    };
+
+    struct CountPre
+    {
+        void operator()(Payload* ptr) const
+        {
+            ptr->data[0] = 1;
+            ++HookCounts::pre;
+        }
+    };
+
+    struct CountPost
+    {
+        void operator()(Payload* ptr) const
+        {
+            ptr->data[0] = 0;
+            ++HookCounts::post;
+        }
+    };
+
+    void countFinal(Payload*)
+    {
+        ++HookCounts::final;
+    }
+
+    // 策略中的处理函数在获取、释放与销毁时各调用一次，无状态的处理函数不占用空间
+    void compileTimeHooks()
+    {
+        using Pool = cppobjectpool::HookedObjectPool<Payload, CountPre, CountPost, cppobjectpool::FunctionHook<&countFinal>>;
+        static_assert(sizeof(Pool) == sizeof(cppobjectpool::HookedObjectPool<Payload>), "empty hooks must not take space");
+        auto pool = Pool::create(0, 4);
+        {
+            auto a = pool->acquire();
+            auto b = pool->acquire();
+            CHECK(a->data[0] == 1 && b->data[0] == 1);
+            CHECK(HookCounts::pre == 2);
+            CHECK(HookCounts::post == 0);
+        }
+        CHECK(HookCounts::post == 2);
+        auto c = pool->acquire();
+        CHECK(HookCounts::pre == 3);
+        pool->release(std::move(c));
+        CHECK(HookCounts::post == 3);
+        CHECK(HookCounts::final == 0);
+        pool->clear();
+        CHECK(HookCounts::final == 2);
+    }
+
+    // 延迟回收的对象在到期之前不会被复用，到期后由 processDelayed() 成批放回空闲列表，clear() 立即释放时间轮中的对象
+    void delayedReleaseWaitsForExpiry()
+    {
+        auto pool = cppobjectpool::ObjectPool<Payload>::create(0, 4);
+        int post = 0;
+        pool->setPostProcess([&](Payload*) { ++post; });
+        auto a = pool->acquire();
+        Payload* raw = a.get();
+        pool->release(std::move(a), std::chrono::milliseconds(50));
+        CHECK(!a);
+        CHECK(pool->getAvailableCount() == 0);
+        CHECK(post == 0);
+        pool->processDelayed();
+        CHECK(pool->getAvailableCount() == 0);
+        // 还在时间轮上的对象不会被交出
+        auto b = pool->acquire();
+        CHECK(b.get() != raw);
+        std::this_thread::sleep_for(std::chrono::milliseconds(80));
+        pool->processDelayed();
+        CHECK(post == 1);
+        CHECK(pool->getAvailableCount() == 1);
+        CHECK(pool->acquire().get() == raw);
+
+        pool->release(std::move(b), std::chrono::milliseconds(1000));
+        CHECK(pool->getRealAllockedCount() == 2);
+        pool->clear();
+        CHECK(pool->getRealAllockedCount() == 0);
+        CHECK(pool->stats().outstanding == 0);
+    }
+
+    // 同时统计 acquire 延迟的策略
+    struct LatencyStatsPolicy : cppobjectpool::DefaultPoolPolicy
+    {
+        static constexpr bool acquireLatencyStats = true;
+    };
+
+    // stats() 区分复用与新建，记录失败、释放、丢弃、在外对象的峰值与延迟直方图
+    void statsCountEveryOutcome()
+    {
+        using Pool = cppobjectpool::BasicObjectPool<Payload, LatencyStatsPolicy>;
+        auto pool = Pool::create(2, 3);
+        auto a = pool->acquire();
+        auto b = pool->acquire();
+        auto c = pool->acquire();
+        CHECK(!pool->acquire());
+        cppobjectpool::PoolStats stats = pool->stats();
+        CHECK(stats.acquires == 3);
+        CHECK(stats.hits == 2);
+        CHECK(stats.creates == 1);
+        CHECK(stats.failures == 1);
+        CHECK(stats.outstanding == 3);
+        CHECK(stats.peakOutstanding == 3);
+        CHECK(stats.allocated == 3);
+        uint64_t timed = 0;
+        for (uint64_t bucket : stats.acquireLatency)
+        {
+            timed += bucket;
+        }
+        CHECK(timed >= stats.acquires);
+
+        a.reset();
+        pool->release(std::move(b));
+        stats = pool->stats();
+        CHECK(stats.releases == 2);
+        CHECK(stats.outstanding == 1);
+        CHECK(stats.peakOutstanding == 3);
+        CHECK(stats.available == 2);
+        CHECK(stats.drops == 0);
+
+        // 初始对象多于 maxSize 时，归还的对象有一个放不回空闲列表
+        auto overfull = Pool::create(4, 3);
+        std::vector<std::unique_ptr<Payload, Pool::CustomDeleter>> batch;
+        CHECK(overfull->acquire_n(4, std::back_inserter(batch)) == 4);
+        overfull->release_n(batch);
+        stats = overfull->stats();
+        CHECK(stats.releases == 4);
+        CHECK(stats.drops == 1);
+        CHECK(stats.available == 3);
+    }
+
+    // 本节点分片耗尽后先借用其它节点的空闲对象，再在其它节点创建；对象释放时回到分配它的分片
+    void numaPoolBorrowsBeforeCreating()
+    {
+        using Pool = cppobjectpool::NumaObjectPool<Payload>;
+        auto pool = std::make_shared<Pool>(0, 4, 2);
+        std::vector<std::unique_ptr<Payload, Pool::CustomDeleter>> held;
+        for (int i = 0; i < 4; ++i)
+        {
+            held.push_back(pool->acquire());
+            CHECK(held.back());
+        }
+        CHECK(pool->stats().creates == 4);
+        CHECK(pool->shard(0).stats().outstanding == 2);
+        CHECK(pool->shard(1).stats().outstanding == 2);
+        held.clear();
+        CHECK(pool->shard(0).getAvailableCount() == 2);
+        CHECK(pool->shard(1).getAvailableCount() == 2);
+        for (int i = 0; i < 4; ++i)
+        {
+            held.push_back(pool->acquire());
+            CHECK(held.back());
+        }
+        CHECK(pool->stats().creates == 4);
+        CHECK(pool->stats().hits == 4);
+        CHECK(pool->getAvailableCount() == 0);
+    }
+
+    // trim() 只销毁整个窗口内都没有被用到的空闲对象(最低水位高出 minIdle 的部分)，并调用最终处理函数
+    void trimFreesIdleBelowLowWater()
+    {
+        auto pool = cppobjectpool::ObjectPool<Payload>::create(8, 16);
+        int finals = 0;
+        pool->setFinalProcess([&](Payload*) { ++finals; });
+        CHECK(pool->trim() == 0);
+        pool->setTrimPolicy(std::chrono::milliseconds(0), 2);
+        {
+            auto a = pool->acquire();
+            auto b = pool->acquire();
+            auto c = pool->acquire();
+        }
+        CHECK(pool->getAvailableCount() == 8);
+        // 窗口内空闲数量最低为 5，其中高出 minIdle 的 3 个被销毁
+        CHECK(pool->trim() == 3);
+        CHECK(finals == 3);
+        CHECK(pool->getAvailableCount() == 5);
+        CHECK(pool->stats().trimmed == 3);
+        // 下一个窗口没有任何获取，空闲对象降到 minIdle 为止
+        CHECK(pool->trim() == 3);
+        CHECK(pool->trim() == 0);
+        CHECK(pool->getAvailableCount() == 2);
+        CHECK(pool->getRealAllockedCount() == 2);
+    }
+
+    // createParallel() 并行创建初始对象，prewarm() 在后台补充到目标数量并通过 future 与 awaitWarm() 给出新建的数量
+    void parallelAndBackgroundWarmup()
+    {
+        using Pool = cppobjectpool::ObjectPool<Payload>;
+        auto pool = Pool::createParallel(8, 16, 4);
+        CHECK(pool->getAvailableCount() == 8);
+        CHECK(pool->stats().allocated == 8);
+        CHECK(pool->stats().creates == 0);
+        CHECK(pool->awaitWarm() == 8);
+
+        auto warm = pool->prewarm(12, 2);
+        CHECK(warm.get() == 4);
+        CHECK(pool->awaitWarm() == 4);
+        CHECK(pool->getAvailableCount() == 12);
+        // 目标超过 maxSize 时只补充到 maxSize
+        CHECK(pool->prewarm(100).get() == 4);
+        CHECK(pool->getRealAllockedCount() == 16);
+        CHECK(Pool::create(0, 4)->awaitWarm() == 0);
+
+        // 任何一个对象创建失败时 createParallel() 抛出该异常，已经创建的对象随对象池销毁
+        Fragile::budget = 3;
+        bool threw = false;
+        try
+        {
+            cppobjectpool::ObjectPool<Fragile>::createParallel(8, 8, 2);
+        }
+        catch (const std::runtime_error&)
+        {
+            threw = true;
+        }
+        CHECK(threw);
+        CHECK(Fragile::live == 0);
+    }
+
+    // 所有分片共享一个全局 maxSize；本地分片没有空闲对象时从相邻分片窃取，而不是新建
+    void shardedPoolSharesBudgetAndSteals()
+    {
+        using Pool = cppobjectpool::ShardedObjectPool<Payload>;
+        auto pool = std::make_shared<Pool>(6, 8, 4);
+        CHECK(pool->getShardCount() == 4);
+        CHECK(pool->shard(0).getAvailableCount() == 2);
+        CHECK(pool->shard(3).getAvailableCount() == 1);
+        std::vector<std::unique_ptr<Payload, Pool::CustomDeleter>> held;
+        while (auto ptr = pool->acquire())
+        {
+            held.push_back(std::move(ptr));
+            CHECK(held.size() <= 8);
+        }
+        CHECK(held.size() == 8);
+        cppobjectpool::PoolStats stats = pool->stats();
+        CHECK(stats.hits == 6);
+        CHECK(stats.creates == 2);
+        CHECK(stats.outstanding == 8);
+        held.clear();
+        CHECK(pool->getAvailableCount() == 8);
+        for (int i = 0; i < 8; ++i)
+        {
+            held.push_back(pool->acquire());
+            CHECK(held.back());
+        }
+        CHECK(pool->stats().creates == 2);
+        CHECK(!pool->acquire());
+    }
+
+    // 带 reset() 的对象，记录构造与析构的次数
+    struct Message
+    {
+        static inline int constructed = 0;
+        static inline int destroyed = 0;
+
+        std::vector<char> body;
+        int tag = 0;
+
+        Message()
+        {
+            ++constructed;
+        }
+        explicit Message(int tag)
+            : tag(tag)
+        {
+            ++constructed;
+        }
+        ~Message()
+        {
+            ++destroyed;
+        }
+        void reset()
+        {
+            body.clear();
+        }
+    };
+
+    // 归还时调用 T::reset()，对象不被析构，成员的容量得以保留；acquire(args...) 在原来的存储中重新构造
+    void resetKeepsCapacity()
+    {
+        using Pool = cppobjectpool::ObjectPool<Message>;
+        auto pool = Pool::create(0, 4);
+        auto msg = pool->acquire();
+        Message* raw = msg.get();
+        msg->body.resize(4096);
+        size_t capacity = msg->body.capacity();
+        pool->release(std::move(msg));
+        msg = pool->acquire();
+        CHECK(msg.get() == raw);
+        CHECK(msg->body.empty());
+        CHECK(msg->body.capacity() == capacity);
+        CHECK(Message::constructed == 1);
+        CHECK(Message::destroyed == 0);
+        msg.reset();
+
+        // 复用空闲对象时以调用方的参数原地重新构造，存储不变
+        auto tagged = pool->acquire(7);
+        CHECK(tagged.get() == raw);
+        CHECK(tagged->tag == 7);
+        CHECK(Message::constructed == 2);
+        CHECK(Message::destroyed == 1);
+        // 没有空闲对象时直接以这些参数构造新对象
+        auto fresh = pool->acquire(9);
+        CHECK(fresh.get() != raw);
+        CHECK(fresh->tag == 9);
+        CHECK(Message::constructed == 3);
+    }
+
+    // 按大小级别构造的缓冲区
+    struct Buffer
+    {
+        explicit Buffer(size_t size)
+            : bytes(size)
+        {
+        }
+
+        std::vector<char> bytes;
+    };
+
+    // acquire(size) 从能容纳 size 的最小级别获取，级别各自受 maxSize 限制，对象释放时回到所属级别
+    void sizeClassRouting()
+    {
+        using Pool = cppobjectpool::SizeClassObjectPool<Buffer>;
+        auto pool = Pool::create({ 16384, 1024, 4096, 1024 }, 0, 2);
+        CHECK(pool->getClassCount() == 3);
+        CHECK(pool->getClassSize(0) == 1024);
+        auto small = pool->acquire(1);
+        auto exact = pool->acquire(4096);
+        auto medium = pool->acquire(3000);
+        CHECK(small->bytes.size() == 1024);
+        CHECK(exact->bytes.size() == 4096);
+        CHECK(medium->bytes.size() == 4096);
+        CHECK(!pool->acquire(16385));
+        // 4K 级别已达到最大大小，不会退到更大的级别
+        CHECK(!pool->acquire(2048));
+        CHECK(pool->shard(1).stats().outstanding == 2);
+        Buffer* raw = medium.get();
+        pool->release(std::move(medium));
+        CHECK(pool->shard(1).getAvailableCount() == 1);
+        CHECK(pool->getAvailableCount() == 1);
+        CHECK(pool->acquire(2048).get() == raw);
+    }
+
+    // 静态对象池中的对象，记录构造次数
+    struct Quote
+    {
+        static inline std::atomic<int> constructed{ 0 };
+
+        Quote()
+        {
+            ++constructed;
+        }
+        void reset()
+        {
+            owner = -1;
+        }
+
+        int owner = -1;
+    };
+
+    // 全局静态对象池，不使用动态内存
+    cppobjectpool::StaticObjectPool<Quote, 4> quotes;
+
+    static_assert(sizeof(cppobjectpool::StaticObjectPool<Quote, 100>::Index) == 2, "small pools use 16-bit indices");
+    static_assert(sizeof(cppobjectpool::StaticObjectPool<Quote, 70000>::Index) == 4, "large pools use 32-bit indices");
+
+    // 容量用尽时返回空句柄，归还的对象被复用而不重新构造；并发获取时同一个对象不会同时交给两个线程
+    void staticPoolExhaustionAndReuse()
+    {
+        CHECK(quotes.capacity() == 4);
+        CHECK(quotes.getAvailableCount() == 4);
+        std::vector<cppobjectpool::StaticObjectPool<Quote, 4>::Handle> held;
+        for (int i = 0; i < 4; ++i)
+        {
+            held.push_back(quotes.acquire());
+            CHECK(held.back());
+        }
+        CHECK(!quotes.acquire());
+        CHECK(quotes.getAvailableCount() == 0);
+        Quote* raw = held.back().get();
+        raw->owner = 1;
+        quotes.release(std::move(held.back()));
+        held.pop_back();
+        auto again = quotes.acquire();
+        CHECK(again.get() == raw);
+        CHECK(again->owner == -1);
+        again.reset();
+        held.clear();
+        CHECK(Quote::constructed == 4);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([t] {
+                for (int i = 0; i < 20000; ++i)
+                {
+                    if (auto quote = quotes.acquire())
+                    {
+                        CHECK(quote->owner == -1);
+                        quote->owner = t;
+                        std::this_thread::yield();
+                        CHECK(quote->owner == t);
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        CHECK(quotes.getAvailableCount() == 4);
+        CHECK(Quote::constructed == 4);
+    }
+
+    // 最后一个 shared_ptr 与 weak_ptr 都释放后对象才回到对象池；仍有 weak_ptr 时对象不会被复用
+    void sharedHandlesReturnOnLastReference()
+    {
+        using Pool = cppobjectpool::SharedObjectPool<Payload>;
+        auto pool = Pool::create(1, 2);
+        std::shared_ptr<Payload> first = pool->acquire_shared();
+        Payload* raw = first.get();
+        std::shared_ptr<Payload> copy = first;
+        std::weak_ptr<Payload> weak = first;
+        CHECK(first.use_count() == 2);
+        CHECK(pool->stats().outstanding == 1);
+        first.reset();
+        copy.reset();
+        CHECK(weak.expired());
+        CHECK(!weak.lock());
+        // 控制块还在，对象不能交给别人
+        CHECK(pool->getAvailableCount() == 0);
+        auto other = pool->acquire_shared();
+        CHECK(other.get() != raw);
+        weak.reset();
+        CHECK(pool->getAvailableCount() == 1);
+        CHECK(pool->stats().outstanding == 1);
+        auto reused = pool->acquire_shared();
+        CHECK(reused.get() == raw);
+        CHECK(pool->stats().creates == 1);
+    }
+
+    // 其它线程释放的对象进入获取线程的远程释放列表，而不是释放线程的缓存；获取线程的缓存为空时一次取回
+    void remoteFreeReturnsToOwner()
+    {
+        using Pool = cppobjectpool::ObjectPool<Payload>;
+        auto pool = Pool::create(0, 16);
+        pool->setThreadCacheSize(8);
+        std::vector<std::unique_ptr<Payload, Pool::CustomDeleter>> held;
+        std::vector<Payload*> addresses;
+        for (int i = 0; i < 4; ++i)
+        {
+            held.push_back(pool->acquire());
+            addresses.push_back(held.back().get());
+        }
+        CHECK(pool->stats().creates == 4);
+        std::thread releaser([&] {
+            held.clear();
+        });
+        releaser.join();
+        // 远程释放列表中的对象在取回之前不计入空闲数量，但已不在外
+        CHECK(pool->getAvailableCount() == 0);
+        CHECK(pool->stats().outstanding == 0);
+        for (int i = 0; i < 4; ++i)
+        {
+            held.push_back(pool->acquire());
+            CHECK(std::find(addresses.begin(), addresses.end(), held.back().get()) != addresses.end());
+        }
+        CHECK(pool->stats().creates == 4);
+        CHECK(pool->stats().outstanding == 4);
+    }
+
+    // 锁策略提供的锁互斥地保护临界区，try_lock 在锁被持有时失败
+    template <typename Lock>
+    void lockExcludes()
+    {
+        Lock lock;
+        CHECK(lock.try_lock());
+        CHECK(!lock.try_lock());
+        lock.unlock();
+        long counter = 0;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&] {
+                for (int i = 0; i < 50000; ++i)
+                {
+                    std::lock_guard<Lock> guard(lock);
+                    ++counter;
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        CHECK(counter == 4 * 50000);
+    }
+
+    // 以不同的锁策略保护空闲列表，并发获取与释放后对象数量不超过 maxSize，也没有对象滞留在外
+    template <typename Pool>
+    void lockPolicyPoolChurn()
+    {
+        auto pool = Pool::create(0, 8);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t)
+        {
+            threads.emplace_back([&] {
+                for (int i = 0; i < 20000; ++i)
+                {
+                    auto a = pool->acquire();
+                    auto b = pool->acquire();
+                    CHECK(a && b && a != b);
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        cppobjectpool::PoolStats stats = pool->stats();
+        CHECK(stats.outstanding == 0);
+        CHECK(stats.allocated <= 8);
+        CHECK(stats.acquires == 4 * 2 * 20000);
+    }
+
+    // 按占用位图遍历：在外对象按内存顺序访问，空闲对象包括线程本地缓存与延迟回收时间轮中的对象，clear() 之后都不再被访问
+    void bitmapIteration()
+    {
+        using Pool = cppobjectpool::BasicObjectPool<Payload, cppobjectpool::SlabBitmapPoolPolicy>;
+        auto pool = Pool::create(100, 200);
+        std::vector<std::unique_ptr<Payload, Pool::CustomDeleter>> held;
+        for (int i = 0; i < 150; ++i)
+        {
+            held.push_back(pool->acquire());
+        }
+        held.erase(held.begin() + 10, held.begin() + 20);
+        CHECK(pool->for_each_outstanding([](Payload&) {}) == 140);
+        CHECK(pool->for_each_idle([](Payload&) {}) == 10);
+        // 访问到的正是在外的对象；前 90 个位于初始对象所在的块，按地址递增
+        std::vector<const Payload*> visited;
+        pool->for_each_outstanding([&](Payload& payload) {
+            visited.push_back(&payload);
+            payload.data[0] = 1;
+        });
+        CHECK(std::is_sorted(visited.begin(), visited.begin() + 90));
+        for (auto& ptr : held)
+        {
+            CHECK(ptr->data[0] == 1);
+        }
+
+        pool->release(std::move(held.back()), std::chrono::milliseconds(1000));
+        held.pop_back();
+        pool->setThreadCacheSize(8);
+        pool->acquire().reset();
+        CHECK(pool->for_each_outstanding([](Payload&) {}) == 139);
+        CHECK(pool->for_each_idle([](Payload&) {}) == 11);
+        held.clear();
+        pool->clear();
+        CHECK(pool->for_each_outstanding([](Payload&) {}) == 0);
+        CHECK(pool->for_each_idle([](Payload&) {}) == 0);
+    }
+
+    // 空闲对象低于低水位时补充到高水位：maintain() 由调用方驱动，后台模式由补充线程完成；补充的对象不计入 creates
+    void watermarkRefill()
+    {
+        using Pool = cppobjectpool::ObjectPool<Payload>;
+        auto pool = Pool::create(0, 10);
+        pool->setWatermarks(2, 6, false);
+        CHECK(pool->maintain() == 6);
+        CHECK(pool->getAvailableCount() == 6);
+        CHECK(pool->maintain() == 0);
+        std::vector<std::unique_ptr<Payload, Pool::CustomDeleter>> held;
+        for (int i = 0; i < 5; ++i)
+        {
+            held.push_back(pool->acquire());
+        }
+        CHECK(pool->stats().creates == 0);
+        // 空闲 1 个，本应补充 5 个到高水位，但对象总数不能超过 maxSize
+        CHECK(pool->maintain() == 4);
+        CHECK(pool->getAvailableCount() == 5);
+        for (int i = 0; i < 5; ++i)
+        {
+            held.push_back(pool->acquire());
+        }
+        CHECK(pool->maintain() == 0);
+        CHECK(pool->getRealAllockedCount() == 10);
+
+        auto background = Pool::create(0, 10);
+        background->setWatermarks(2, 6);
+        auto first = background->acquire();
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (background->getAvailableCount() < 6 && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        CHECK(background->getAvailableCount() == 6);
+        CHECK(background->stats().creates == 1);
+    }
+
+#if defined(CPPOBJECTPOOL_COROUTINES)
+    // 立即开始执行、结束后自行销毁的协程
+    struct Detached
+    {
+        struct promise_type
+        {
+            Detached get_return_object() { return {}; }
+            std::suspend_never initial_suspend() { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+
+    // 等待对象，拿到后置位 done
+    template <typename Pool>
+    Detached awaitObject(std::shared_ptr<Pool> pool, std::atomic<bool>& done)
+    {
+        auto ptr = co_await pool->acquire_async();
+        done.store(ptr != nullptr);
+    }
+
+    // 唯一的空闲对象还在延迟回收时间轮中时挂起的协程，不需要其它线程调用对象池也能在对象到期后恢复
+    void asyncWaiterWakesOnDelayedRelease()
+    {
+        auto pool = cppobjectpool::ObjectPool<Payload>::create(0, 1);
+        pool->release(pool->acquire(), std::chrono::milliseconds(20));
+        std::atomic<bool> done{ false };
+        awaitObject(pool, done);
+        CHECK(!done.load());
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (!done.load() && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        CHECK(done.load());
+        CHECK(pool->stats().outstanding == 0);
+    }
+
+    // 挂起后由调用方销毁的协程，返回协程句柄
+    struct Suspended
+    {
+        struct promise_type
+        {
+            Suspended get_return_object() { return { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+            std::suspend_never initial_suspend() { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+        std::coroutine_handle<promise_type> handle;
+    };
+
+    // 只保存协程句柄、不恢复协程的执行器
+    struct HoldingExecutor
+    {
+        std::coroutine_handle<> handle;
+        void operator()(std::coroutine_handle<> h) { handle = h; }
+    };
+
+    template <typename Pool>
+    Suspended awaitAndHold(std::shared_ptr<Pool> pool)
+    {
+        auto ptr = co_await pool->acquire_async();
+    }
+
+    template <typename Pool>
+    Suspended awaitOn(std::shared_ptr<Pool> pool, HoldingExecutor& executor)
+    {
+        auto ptr = co_await pool->acquire_async(executor);
+    }
+
+    // 挂起的协程被销毁后等待节点移出等待队列，之后的释放不会写入已经释放的协程帧；
+    // 已经交给协程、还没有被取走的对象回到对象池
+    void destroyedAwaiterLeavesQueue()
+    {
+        auto pool = cppobjectpool::ObjectPool<Payload>::create(0, 1);
+        auto held = pool->acquire();
+        Suspended waiting = awaitAndHold(pool);
+        CHECK(!waiting.handle.done());
+        waiting.handle.destroy();
+        pool->release(std::move(held));
+        CHECK(pool->getAvailableCount() == 1);
+        CHECK(pool->stats().outstanding == 0);
+
+        HoldingExecutor executor;
+        held = pool->acquire();
+        Suspended scheduled = awaitOn(pool, executor);
+        pool->release(std::move(held));
+        CHECK(executor.handle);
+        CHECK(pool->stats().outstanding == 1);
+        scheduled.handle.destroy();
+        CHECK(pool->getAvailableCount() == 1);
+        CHECK(pool->stats().outstanding == 0);
+    }
+#endif
+
+#if defined(CPPOBJECTPOOL_SHARED_MEMORY)
+    // 同一个 Ref 只能被接管一次，接管后的对象可以再次交出
+    void sharedMemoryAdoptOnce()
+    {
+        const std::string name = "/cppobjectpool_test_" + std::to_string(::getpid());
+        auto pool = cppobjectpool::SharedMemoryObjectPool<int>::create(name, 4);
+        cppobjectpool::SharedMemoryObjectPool<int>::unlink(name);
+        auto ref = pool->handoff(pool->acquire());
+        auto first = pool->adopt(ref);
+        CHECK(first);
+        CHECK(!pool->adopt(ref));
+        auto again = pool->handoff(std::move(first));
+        CHECK(pool->adopt(again));
+        CHECK(pool->getAvailableCount() == 4);
+    }
+#endif
+}
+
+int main()
+{
+    const struct
+    {
+        const char* name;
+        void (*run)();
+    } tests[] = {
+        { "lockFreeTrimAndClearRace", lockFreeTrimAndClearRace },
+        { "acquireNThrowingConstructor", acquireNThrowingConstructor<cppobjectpool::ObjectPool<Fragile>> },
+        { "acquireNThrowingConstructorLockFree", acquireNThrowingConstructor<cppobjectpool::LockFreeObjectPool<Fragile>> },
+        { "acquireNRespectsReservation", acquireNRespectsReservation },
+        { "waiterRespectsReservation", waiterRespectsReservation },
+        { "threadCacheDoesNotPinPool", threadCacheDoesNotPinPool },
+        { "crossThreadReleaseAfterDetach", crossThreadReleaseAfterDetach },
+        { "threadCacheIndexReused", threadCacheIndexReused },
+        { "traceEventsOnEveryPath", traceEventsOnEveryPath },
+        { "waitersNeverStall", [] { waitersNeverStall<cppobjectpool::ObjectPool<Payload>>(0); } },
+        { "waitersNeverStallLockFree", [] { waitersNeverStall<cppobjectpool::LockFreeObjectPool<Payload>>(0); } },
+        { "waitersNeverStallThreadCache", [] { waitersNeverStall<cppobjectpool::ObjectPool<Payload>>(4); } },
+        { "numaPoolRespectsMaxSize", numaPoolRespectsMaxSize },
+        { "slabObjectsAreContiguous", slabObjectsAreContiguous },
+        { "compileTimeHooks", compileTimeHooks },
+        { "delayedReleaseWaitsForExpiry", delayedReleaseWaitsForExpiry },
+        { "statsCountEveryOutcome", statsCountEveryOutcome },
+        { "numaPoolBorrowsBeforeCreating", numaPoolBorrowsBeforeCreating },
+        { "trimFreesIdleBelowLowWater", trimFreesIdleBelowLowWater },
+        { "parallelAndBackgroundWarmup", parallelAndBackgroundWarmup },
+        { "shardedPoolSharesBudgetAndSteals", shardedPoolSharesBudgetAndSteals },
+        { "resetKeepsCapacity", resetKeepsCapacity },
+        { "sizeClassRouting", sizeClassRouting },
+        { "staticPoolExhaustionAndReuse", staticPoolExhaustionAndReuse },
+        { "sharedHandlesReturnOnLastReference", sharedHandlesReturnOnLastReference },
+        { "remoteFreeReturnsToOwner", remoteFreeReturnsToOwner },
+        { "spinLockExcludes", lockExcludes<cppobjectpool::SpinLock> },
+        { "adaptiveMutexExcludes", lockExcludes<cppobjectpool::AdaptiveMutex> },
+        { "spinLockPoolChurn", lockPolicyPoolChurn<cppobjectpool::SpinLockObjectPool<Payload>> },
+        { "adaptiveLockPoolChurn", lockPolicyPoolChurn<cppobjectpool::AdaptiveLockObjectPool<Payload>> },
+        { "bitmapIteration", bitmapIteration },
+        { "watermarkRefill", watermarkRefill },
+#if defined(CPPOBJECTPOOL_COROUTINES)
+        { "asyncWaiterWakesOnDelayedRelease", asyncWaiterWakesOnDelayedRelease },
+        { "destroyedAwaiterLeavesQueue", destroyedAwaiterLeavesQueue },
+#endif
+#if defined(CPPOBJECTPOOL_SHARED_MEMORY)
+        { "sharedMemoryAdoptOnce", sharedMemoryAdoptOnce },
+#endif
+    };
+    for (const auto& test : tests)
+    {
+        test.run();
+        std::printf("[ OK ] %s\n", test.name);
+    }
+    return 0;
+}